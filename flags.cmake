@@ -1,4 +1,6 @@
 add_definitions(-g -funwind-tables -ffast-math)
+# clock_gettime, pthreads and friends under -std=c99
+add_definitions(-D_GNU_SOURCE)
 set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -std=c99")
 set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -fpermissive")
 
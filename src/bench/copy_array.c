@@ -0,0 +1,65 @@
+// reports gl_copy_array throughput for the conversions glshim does most
+// build with `make bench_copy_array`
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../gl/array.h"
+
+#define ELEMENTS 65536
+
+typedef struct {
+    const char *name;
+    GLenum from;
+    GLsizei width, stride;
+    GLenum to;
+    GLsizei to_width;
+    GLboolean normalize;
+} pair_t;
+
+static const pair_t pairs[] = {
+    {"ubyte4 -> float4 (normalized)", GL_UNSIGNED_BYTE, 4, 0, GL_FLOAT, 4, true},
+    {"short3 -> float3", GL_SHORT, 3, 0, GL_FLOAT, 3, false},
+    {"float2 -> float2 (stride 32)", GL_FLOAT, 2, 32, GL_FLOAT, 2, false},
+    {"float2 -> float2", GL_FLOAT, 2, 0, GL_FLOAT, 2, false},
+    {"float3 -> float3 (stride 32)", GL_FLOAT, 3, 32, GL_FLOAT, 3, false},
+    {"float3 -> float4", GL_FLOAT, 3, 0, GL_FLOAT, 4, false},
+    {"float4 -> float4 (stride 32)", GL_FLOAT, 4, 32, GL_FLOAT, 4, false},
+    {"ubyte3 -> float4 (normalized)", GL_UNSIGNED_BYTE, 3, 0, GL_FLOAT, 4, true},
+    {"double3 -> float3", GL_DOUBLE, 3, 0, GL_FLOAT, 3, false},
+    {"ushort1 -> uint1", GL_UNSIGNED_SHORT, 1, 0, GL_UNSIGNED_INT, 1, false},
+};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main() {
+    GLubyte *src = malloc(ELEMENTS * 32);
+    for (int i = 0; i < ELEMENTS * 32; i++) {
+        src[i] = rand();
+    }
+    printf("%-32s %10s\n", "conversion", "GB/s");
+    for (int i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        const pair_t *p = &pairs[i];
+        GLsizei stride = p->stride ? p->stride : p->width * gl_sizeof(p->from);
+        double bytes = (double)ELEMENTS * (stride + p->to_width * gl_sizeof(p->to));
+        int runs = 0;
+        double start = now(), elapsed;
+        do {
+            GLvoid *out = gl_copy_array(src, p->from, p->width, p->stride,
+                                        p->to, p->to_width, 0, ELEMENTS, p->normalize);
+            free(out);
+            runs++;
+        } while ((elapsed = now() - start) < 0.25);
+        printf("%-32s %10.2f\n", p->name, bytes * runs / elapsed / 1e9);
+    }
+    free(src);
+    return 0;
+}
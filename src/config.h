@@ -3,3 +3,17 @@
 
 #define MAX_TEX 4
 #define GL_TEXTURE_MAX (GL_TEXTURE0 + MAX_TEX)
+
+// matrix stacks start at the GL minimum depths and grow up to the max
+#define MODELVIEW_STACK_DEPTH 32
+#define PROJECTION_STACK_DEPTH 2
+#define TEXTURE_STACK_DEPTH 2
+#define MAX_MATRIX_STACK_DEPTH 1024
+
+// textures are converted and uploaded through a scratch strip about this big
+#define TEXTURE_STRIP_SIZE (64 * 1024)
+// uploads converting at least this many bytes are split across threads
+#define TEXTURE_THREAD_SIZE (256 * 1024)
+#define MAX_POOL_THREADS 8
+// mipmap levels we keep copies of, enough for 32k textures
+#define MAX_TEXTURE_LEVELS 16
@@ -1,34 +1,218 @@
 #include "array.h"
+#include "buffer.h"
 #include "eval.h"
 #include "gl_str.h"
 
-GLvoid *gl_copy_array(const GLvoid *src,
-                      GLenum from, GLsizei width, GLsizei stride,
-                      GLenum to, GLsizei to_width, GLsizei skip, GLsizei count,
-                      GLboolean normalize) {
-    if (! src || !count)
-        return NULL;
+#include "vectorial/simd4f.h"
 
-    if (! stride)
-        stride = width * gl_sizeof(from);
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-    const char *unknown_str = "libGL: gl_copy_array -> unsupported type %s\n";
-    GLvoid *dst = malloc(count * to_width * gl_sizeof(to));
-    GLsizei from_size = gl_sizeof(from) * width;
-    GLsizei to_size = gl_sizeof(to) * to_width;
+// gl_copy_array kernels. each one handles a single (from, width, to, to_width,
+// normalize) combination, or a from type with any widths for the generic ones
+typedef void (*copy_kernel_t)(GLvoid *dst, uintptr_t in, GLsizei stride,
+                              GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale);
 
-    if (to_width < width) {
-        printf("Warning: gl_copy_array: %i < %i\n", to_width, width);
-        return NULL;
+static void copy_ubyte4_float4(GLvoid *dst, uintptr_t in, GLsizei stride,
+                               GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    simd4f s = simd4f_splat(scale);
+    for (GLsizei i = 0; i < count; i++, out += 4, in += stride) {
+        const GLubyte *v = (const GLubyte *)in;
+        simd4f_ustore4(simd4f_mul(simd4f_create(v[0], v[1], v[2], v[3]), s), out);
     }
+}
 
-    // if stride is weird, we need to be able to arbitrarily shift src
-    // so we leave it in a uintptr_t and cast after incrementing
-    uintptr_t in = (uintptr_t)src;
-    in += stride * skip;
-    if (from == to && to_width >= width) {
+static void copy_short3_float3(GLvoid *dst, uintptr_t in, GLsizei stride,
+                               GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    simd4f s = simd4f_splat(scale);
+    // the last element can't take a 4-wide store
+    for (GLsizei i = 0; i < count - 1; i++, out += 3, in += stride) {
+        const GLshort *v = (const GLshort *)in;
+        simd4f_ustore4(simd4f_mul(simd4f_create(v[0], v[1], v[2], 0), s), out);
+    }
+    if (count > 0) {
+        const GLshort *v = (const GLshort *)in;
+        simd4f_ustore3(simd4f_mul(simd4f_create(v[0], v[1], v[2], 0), s), out);
+    }
+}
+
+static void copy_float2_float2(GLvoid *dst, uintptr_t in, GLsizei stride,
+                               GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    if (stride == 2 * sizeof(GLfloat)) {
+        memcpy(out, (const GLvoid *)in, count * 2 * sizeof(GLfloat));
+        return;
+    }
+    for (GLsizei i = 0; i < count; i++, out += 2, in += stride) {
+        const GLfloat *v = (const GLfloat *)in;
+        out[0] = v[0];
+        out[1] = v[1];
+    }
+}
+
+static void copy_float3_float3(GLvoid *dst, uintptr_t in, GLsizei stride,
+                               GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    if (stride == 3 * sizeof(GLfloat)) {
+        memcpy(out, (const GLvoid *)in, count * 3 * sizeof(GLfloat));
+        return;
+    }
+    for (GLsizei i = 0; i < count - 1; i++, out += 3, in += stride) {
+        simd4f_ustore4(simd4f_uload3((const GLfloat *)in), out);
+    }
+    if (count > 0) {
+        simd4f_ustore3(simd4f_uload3((const GLfloat *)in), out);
+    }
+}
+
+static void copy_float3_float4(GLvoid *dst, uintptr_t in, GLsizei stride,
+                               GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    simd4f w = simd4f_create(0, 0, 0, 1);
+    for (GLsizei i = 0; i < count; i++, out += 4, in += stride) {
+        simd4f_ustore4(simd4f_add(simd4f_uload3((const GLfloat *)in), w), out);
+    }
+}
+
+static void copy_float4_float4(GLvoid *dst, uintptr_t in, GLsizei stride,
+                               GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    if (stride == 4 * sizeof(GLfloat)) {
+        memcpy(out, (const GLvoid *)in, count * 4 * sizeof(GLfloat));
+        return;
+    }
+    for (GLsizei i = 0; i < count; i++, out += 4, in += stride) {
+        simd4f_ustore4(simd4f_uload4((const GLfloat *)in), out);
+    }
+}
+
+static void copy_double3_float3(GLvoid *dst, uintptr_t in, GLsizei stride,
+                                GLsizei width, GLsizei to_width, GLsizei count, GLfloat scale) {
+    GLfloat *out = dst;
+    for (GLsizei i = 0; i < count; i++, out += 3, in += stride) {
+        const GLdouble *v = (const GLdouble *)in;
+        out[0] = v[0];
+        out[1] = v[1];
+        out[2] = v[2];
+    }
+}
+
+// any width of a given type to float, missing components padded like GL does
+#define COPY_TO_FLOAT_LOOP(type, expr)                                              \
+    for (GLsizei i = 0; i < count; i++, out += to_width, in += stride) {            \
+        const type *v = (const type *)in;                                           \
+        GLsizei j = 0;                                                              \
+        for (; j < width; j++) {                                                    \
+            out[j] = expr;                                                          \
+        }                                                                           \
+        for (; j < to_width; j++) {                                                 \
+            out[j] = (j == 3) ? 1 : 0;                                              \
+        }                                                                           \
+    }
+
+#define COPY_TO_FLOAT(name, type)                                                   \
+    static void copy_##name##_float(GLvoid *dst, uintptr_t in, GLsizei stride,      \
+                                    GLsizei width, GLsizei to_width, GLsizei count, \
+                                    GLfloat scale) {                                \
+        GLfloat *out = dst;                                                         \
+        if (scale == 1.0f) {                                                        \
+            COPY_TO_FLOAT_LOOP(type, v[j])                                          \
+        } else {                                                                    \
+            COPY_TO_FLOAT_LOOP(type, v[j] * scale)                                  \
+        }                                                                           \
+    }
+
+COPY_TO_FLOAT(byte, GLbyte)
+COPY_TO_FLOAT(ubyte, GLubyte)
+COPY_TO_FLOAT(short, GLshort)
+COPY_TO_FLOAT(ushort, GLushort)
+COPY_TO_FLOAT(int, GLint)
+COPY_TO_FLOAT(uint, GLuint)
+COPY_TO_FLOAT(fixed, GLint)
+COPY_TO_FLOAT(float, GLfloat)
+COPY_TO_FLOAT(double, GLdouble)
+#undef COPY_TO_FLOAT
+#undef COPY_TO_FLOAT_LOOP
+
+// index widening for glDrawElements
+#define COPY_TO_UINT(name, type)                                                    \
+    static void copy_##name##_uint(GLvoid *dst, uintptr_t in, GLsizei stride,       \
+                                   GLsizei width, GLsizei to_width, GLsizei count,  \
+                                   GLfloat scale) {                                 \
+        GLuint *out = dst;                                                          \
+        if (stride == sizeof(type)) {                                               \
+            const type *v = (const type *)in;                                       \
+            for (GLsizei i = 0; i < count; i++) {                                   \
+                out[i] = v[i];                                                      \
+            }                                                                       \
+            return;                                                                 \
+        }                                                                           \
+        for (GLsizei i = 0; i < count; i++, in += stride) {                         \
+            out[i] = *(const type *)in;                                             \
+        }                                                                           \
+    }
+
+COPY_TO_UINT(ubyte, GLubyte)
+COPY_TO_UINT(ushort, GLushort)
+#undef COPY_TO_UINT
+
+static const struct {
+    GLenum from;
+    GLsizei width;
+    GLenum to;
+    GLsizei to_width;
+    GLboolean normalize;
+    copy_kernel_t kernel;
+} copy_kernels[] = {
+    {GL_UNSIGNED_BYTE, 4, GL_FLOAT, 4, true, copy_ubyte4_float4},
+    {GL_UNSIGNED_BYTE, 4, GL_FLOAT, 4, false, copy_ubyte4_float4},
+    {GL_SHORT, 3, GL_FLOAT, 3, false, copy_short3_float3},
+    {GL_FLOAT, 2, GL_FLOAT, 2, false, copy_float2_float2},
+    {GL_FLOAT, 3, GL_FLOAT, 3, false, copy_float3_float3},
+    {GL_FLOAT, 3, GL_FLOAT, 4, false, copy_float3_float4},
+    {GL_FLOAT, 4, GL_FLOAT, 4, false, copy_float4_float4},
+    {GL_DOUBLE, 3, GL_FLOAT, 3, false, copy_double3_float3},
+    {GL_UNSIGNED_BYTE, 1, GL_UNSIGNED_INT, 1, false, copy_ubyte_uint},
+    {GL_UNSIGNED_SHORT, 1, GL_UNSIGNED_INT, 1, false, copy_ushort_uint},
+};
+
+static copy_kernel_t copy_kernel(GLenum from, GLsizei width, GLenum to, GLsizei to_width, GLboolean normalize) {
+    for (int i = 0; i < sizeof(copy_kernels) / sizeof(copy_kernels[0]); i++) {
+        if (copy_kernels[i].from == from && copy_kernels[i].width == width &&
+            copy_kernels[i].to == to && copy_kernels[i].to_width == to_width &&
+            copy_kernels[i].normalize == normalize) {
+            return copy_kernels[i].kernel;
+        }
+    }
+    if (to == GL_FLOAT) {
+        switch (from) {
+            case GL_BYTE:           return copy_byte_float;
+            case GL_UNSIGNED_BYTE:  return copy_ubyte_float;
+            case GL_SHORT:          return copy_short_float;
+            case GL_UNSIGNED_SHORT: return copy_ushort_float;
+            case GL_INT:            return copy_int_float;
+            case GL_UNSIGNED_INT:   return copy_uint_float;
+            case GL_FIXED:          return copy_fixed_float;
+            case GL_FLOAT:          return copy_float_float;
+            case GL_DOUBLE:         return copy_double_float;
+        }
+    }
+    return NULL;
+}
+
+// fallback for combinations without a kernel, switching on type per element
+static bool copy_array_generic(GLvoid *dst, uintptr_t in,
+                               GLenum from, GLsizei width, GLsizei stride,
+                               GLenum to, GLsizei to_width, GLsizei count,
+                               GLboolean normalize) {
+    const char *unknown_str = "libGL: gl_copy_array -> unsupported type %s\n";
+    if (from == to) {
+        GLsizei from_size = gl_sizeof(from) * width;
         GL_TYPE_SWITCH(out, dst, to,
-            for (int i = skip; i < (skip + count); i++) {
+            for (int i = 0; i < count; i++) {
                 memcpy(out, (GLvoid *)in, from_size);
                 for (int j = width; j < to_width; j++) {
                     out[j] = 0;
@@ -38,65 +222,256 @@ GLvoid *gl_copy_array(const GLvoid *src,
             },
             default:
                 printf(unknown_str, gl_str(from));
-                return NULL;
+                return false;
         )
-    } else {
-        GL_TYPE_SWITCH(out, dst, to,
-            for (int i = skip; i < (skip + count); i++) {
-                GL_TYPE_SWITCH(input, in, from,
-                    for (int j = 0; j < width; j++) {
-                        if (from != to && normalize) {
-                            out[j] = input[j] * gl_max_value(to);
-                            out[j] /= gl_max_value(from);
-                        } else {
-                            out[j] = input[j];
-                        }
-                    }
-                    for (int j = width; j < to_width; j++) {
-                        if (j == 3) out[j] = 1;
-                        else out[j] = 0;
+        return true;
+    }
+    GL_TYPE_SWITCH(out, dst, to,
+        for (int i = 0; i < count; i++) {
+            GL_TYPE_SWITCH(input, in, from,
+                for (int j = 0; j < width; j++) {
+                    if (normalize) {
+                        out[j] = input[j] * gl_max_value(to);
+                        out[j] /= gl_max_value(from);
+                    } else {
+                        out[j] = input[j];
                     }
-                    out += to_width;
-                    in += stride;
-                ,
-                    default:
-                        printf(unknown_str, gl_str(from));
-                        return NULL;
-                )
-            },
-            default:
-                printf(unknown_str, gl_str(to));
-                return NULL;
-        )
+                }
+                for (int j = width; j < to_width; j++) {
+                    if (j == 3) out[j] = 1;
+                    else out[j] = 0;
+                }
+                out += to_width;
+                in += stride;
+            ,
+                default:
+                    printf(unknown_str, gl_str(from));
+                    return false;
+            )
+        },
+        default:
+            printf(unknown_str, gl_str(to));
+            return false;
+    )
+    return true;
+}
+
+GLvoid *gl_copy_array(const GLvoid *src,
+                      GLenum from, GLsizei width, GLsizei stride,
+                      GLenum to, GLsizei to_width, GLsizei skip, GLsizei count,
+                      GLboolean normalize) {
+    if (! src || !count)
+        return NULL;
+
+    if (to_width < width) {
+        printf("Warning: gl_copy_array: %i < %i\n", to_width, width);
+        return NULL;
+    }
+
+    if (! stride)
+        stride = width * gl_sizeof(from);
+
+    // normalizing only changes anything between different integer ranges
+    if (from == to || from == GL_FLOAT || from == GL_DOUBLE) {
+        normalize = false;
     }
 
+    // if stride is weird, we need to be able to arbitrarily shift src
+    // so we leave it in a uintptr_t and cast after incrementing
+    uintptr_t in = (uintptr_t)src + stride * skip;
+    GLvoid *dst = malloc(count * to_width * gl_sizeof(to));
+
+    copy_kernel_t kernel = copy_kernel(from, width, to, to_width, normalize);
+    if (kernel) {
+        GLfloat scale = 1.0f;
+        if (from == GL_FIXED) {
+            scale = 1.0f / 65536.0f;
+        } else if (normalize) {
+            scale = 1.0f / gl_max_value(from);
+        }
+        kernel(dst, in, stride, width, to_width, count, scale);
+    } else if (! copy_array_generic(dst, in, from, width, stride, to, to_width, count, normalize)) {
+        free(dst);
+        return NULL;
+    }
     return dst;
 }
 
 GLvoid *gl_copy_pointer(pointer_state_t *ptr, GLsizei width, GLsizei skip, GLsizei count, GLboolean normalize) {
-    return gl_copy_array(ptr->pointer, ptr->type, ptr->size, ptr->stride, GL_FLOAT, width, skip, count, normalize);
+    return gl_copy_array(gl_pointer_data(ptr), ptr->type, ptr->size, ptr->stride, GL_FLOAT, width, skip, count, normalize);
 }
 
-GLfloat *gl_pointer_index(pointer_state_t *p, GLint index) {
-    static GLfloat buf[4];
-    GLsizei size = gl_sizeof(p->type);
-    GLsizei stride = p->stride ? p->stride : size * p->size;
-    uintptr_t ptr = (uintptr_t)p->pointer + (stride * index);
-
-    GL_TYPE_SWITCH(src, ptr, p->type,
-        for (int i = 0; i < p->size; i++) {
-            buf[i] = src[i];
+// converts arrays that share a stride in a single pass over the vertices,
+// instead of one pass per array. only GL_FLOAT and GL_UNSIGNED_BYTE (times
+// scale) are handled. a 4-component vertex is divided by w, and any other
+// components past width are dropped.
+void gl_copy_interleaved(gl_attrib_t *attribs, int n, GLsizei stride, GLsizei skip, GLsizei count, const GLuint *gather) {
+    for (GLsizei i = 0; i < count; i++) {
+        uintptr_t offset = (uintptr_t)(gather ? gather[i] : skip + i) * stride;
+        for (int a = 0; a < n; a++) {
+            gl_attrib_t *attrib = &attribs[a];
+            GLfloat v[4] = {0, 0, 0, 1};
+            if (attrib->type == GL_FLOAT) {
+                const GLfloat *in = (const GLfloat *)(attrib->src + offset);
+                for (int j = 0; j < attrib->size; j++) {
+                    v[j] = in[j];
+                }
+            } else {
+                const GLubyte *in = attrib->src + offset;
+                for (int j = 0; j < attrib->size; j++) {
+                    v[j] = in[j] * attrib->scale;
+                }
+            }
+            if (attrib->size == 4 && attrib->width == 3) {
+                v[0] /= v[3];
+                v[1] /= v[3];
+                v[2] /= v[3];
+            }
+            memcpy(attrib->out + i * attrib->width, v, attrib->width * sizeof(GLfloat));
         }
-        // zero anything not set by the pointer
-        for (int i = p->size; i < 4; i++) {
-            buf[i] = 0;
-        },
+    }
+}
+
+// one gather loop per source type, so the type switch happens once per array
+#define GATHER_KERNEL(name, type)                                                    \
+    static void gather_##name(GLfloat *out, uintptr_t src, GLsizei stride,           \
+                              GLsizei size, GLsizei width, GLfloat scale,            \
+                              const GLuint *indices, GLsizei count) {                \
+        if (size == 4 && width == 4) {                                               \
+            simd4f s = simd4f_splat(scale);                                          \
+            for (GLsizei i = 0; i < count; i++, out += 4) {                          \
+                const type *in = (const type *)(src + (uintptr_t)indices[i] * stride); \
+                simd4f v = simd4f_create(in[0], in[1], in[2], in[3]);                \
+                simd4f_ustore4(simd4f_mul(v, s), out);                               \
+            }                                                                        \
+            return;                                                                  \
+        }                                                                            \
+        for (GLsizei i = 0; i < count; i++, out += width) {                          \
+            const type *in = (const type *)(src + (uintptr_t)indices[i] * stride);   \
+            GLsizei j = 0;                                                           \
+            for (; j < size; j++) {                                                  \
+                out[j] = in[j] * scale;                                              \
+            }                                                                        \
+            for (; j < width; j++) {                                                 \
+                out[j] = (j == 3) ? 1 : 0;                                           \
+            }                                                                        \
+        }                                                                            \
+    }
+
+GATHER_KERNEL(byte, GLbyte)
+GATHER_KERNEL(ubyte, GLubyte)
+GATHER_KERNEL(short, GLshort)
+GATHER_KERNEL(ushort, GLushort)
+GATHER_KERNEL(int, GLint)
+GATHER_KERNEL(uint, GLuint)
+GATHER_KERNEL(float, GLfloat)
+GATHER_KERNEL(double, GLdouble)
+#undef GATHER_KERNEL
+
+// copies the elements named by indices out of a client array as floats, in index order
+GLfloat *gl_gather_pointer(pointer_state_t *p, GLsizei width, const GLuint *indices, GLsizei count, GLboolean normalize) {
+    const GLvoid *data = gl_pointer_data(p);
+    if (! data || ! count)
+        return NULL;
+
+    if (width < p->size) {
+        printf("Warning: gl_gather_pointer: %i < %i\n", width, p->size);
+        return NULL;
+    }
+
+    void (*gather)(GLfloat *, uintptr_t, GLsizei, GLsizei, GLsizei, GLfloat, const GLuint *, GLsizei);
+    switch (p->type) {
+        case GL_BYTE:           gather = gather_byte; break;
+        case GL_UNSIGNED_BYTE:  gather = gather_ubyte; break;
+        case GL_SHORT:          gather = gather_short; break;
+        case GL_UNSIGNED_SHORT: gather = gather_ushort; break;
+        case GL_FIXED:
+        case GL_INT:            gather = gather_int; break;
+        case GL_UNSIGNED_INT:   gather = gather_uint; break;
+        case GL_FLOAT:          gather = gather_float; break;
+        case GL_DOUBLE:         gather = gather_double; break;
         default:
-            printf("libGL: unsupported pointer type: %s\n", gl_str(p->type));
-    )
-    return buf;
+            printf("libGL: gl_gather_pointer -> unsupported type %s\n", gl_str(p->type));
+            return NULL;
+    }
+
+    GLfloat scale = 1.0f;
+    if (p->type == GL_FIXED) {
+        scale = 1.0f / 65536.0f;
+    } else if (normalize) {
+        scale = 1.0f / gl_max_value(p->type);
+    }
+    GLsizei stride = p->stride ? p->stride : p->size * gl_sizeof(p->type);
+    GLfloat *dst = malloc(count * width * sizeof(GLfloat));
+    gather(dst, (uintptr_t)data, stride, p->size, width, scale, indices, count);
+    return dst;
 }
 
+// element fetchers for every type/size combination, normalized or not
+#define FETCH(name, type, size, div)                                 \
+    static void fetch_##name##_##size(const GLvoid *src, GLfloat *out) { \
+        const type *in = (const type *)src;                          \
+        for (int i = 0; i < size; i++) {                            \
+            out[i] = in[i] / (GLfloat)(div);                         \
+        }                                                            \
+        for (int i = size; i < 4; i++) {                             \
+            out[i] = (i == 3) ? 1 : 0;                               \
+        }                                                            \
+    }
+
+#define FETCH_SIZES(name, type, div) \
+    FETCH(name, type, 1, div)          \
+    FETCH(name, type, 2, div)          \
+    FETCH(name, type, 3, div)          \
+    FETCH(name, type, 4, div)
+
+#define FETCH_TYPE(name, type, max) \
+    FETCH_SIZES(name, type, 1)      \
+    FETCH_SIZES(name##_norm, type, max)
+
+FETCH_TYPE(byte, GLbyte, 127)
+FETCH_TYPE(ubyte, GLubyte, 255)
+FETCH_TYPE(short, GLshort, 32767)
+FETCH_TYPE(ushort, GLushort, 65535)
+FETCH_TYPE(int, GLint, 2147483647)
+FETCH_TYPE(uint, GLuint, 4294967295u)
+FETCH_TYPE(float, GLfloat, 1)
+FETCH_TYPE(double, GLdouble, 1)
+// fixed point is scaled either way
+FETCH_SIZES(fixed, GLint, 65536)
+FETCH_SIZES(fixed_norm, GLint, 65536)
+#undef FETCH_TYPE
+#undef FETCH_SIZES
+#undef FETCH
+
+gl_fetch_t gl_pointer_fetch(GLenum type, GLint size, GLboolean normalize) {
+    if (size < 1 || size > 4) {
+        return NULL;
+    }
+    #define fetch_case(constant, name)                                            \
+        case constant: {                                                          \
+            static const gl_fetch_t fetch[2][4] = {                               \
+                {fetch_##name##_1, fetch_##name##_2, fetch_##name##_3, fetch_##name##_4}, \
+                {fetch_##name##_norm_1, fetch_##name##_norm_2,                    \
+                 fetch_##name##_norm_3, fetch_##name##_norm_4},                   \
+            };                                                                    \
+            return fetch[normalize ? 1 : 0][size - 1];                            \
+        }
+    switch (type) {
+        fetch_case(GL_BYTE, byte)
+        fetch_case(GL_UNSIGNED_BYTE, ubyte)
+        fetch_case(GL_SHORT, short)
+        fetch_case(GL_UNSIGNED_SHORT, ushort)
+        fetch_case(GL_INT, int)
+        fetch_case(GL_UNSIGNED_INT, uint)
+        fetch_case(GL_FIXED, fixed)
+        fetch_case(GL_FLOAT, float)
+        fetch_case(GL_DOUBLE, double)
+    }
+    #undef fetch_case
+    printf("libGL: unsupported pointer type: %s\n", gl_str(type));
+    return NULL;
+}
 
 GLfloat *copy_eval_double(GLenum target, GLint ustride, GLint uorder,
                           GLint vstride, GLint vorder,
@@ -126,17 +501,193 @@ GLfloat *copy_eval_double(GLenum target, GLint ustride, GLint uorder,
     return points;
 }
 
-void normalize_indices(GLushort *indices, GLsizei *max, GLsizei *min, GLsizei count) {
-    *max = 0;
-    *min = -1;
-    for (int i = 0; i < count; i++) {
-        GLsizei n = indices[i];
-        if (*min == -1)
-            *min = n;
-        *min = (n < *min) ? n : *min;
-        *max = (n > *max) ? n : *max;
+// min/max scans for index arrays, 16 bytes at a time where SIMD is available
+static void index_range_ubyte(const GLubyte *src, GLsizei count, GLuint *min, GLuint *max) {
+    GLubyte lo = 0xFF, hi = 0;
+    GLsizei i = 0;
+#if defined(__SSE2__)
+    if (count >= 16) {
+        __m128i vlo = _mm_set1_epi8(0xFF), vhi = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            vlo = _mm_min_epu8(vlo, v);
+            vhi = _mm_max_epu8(vhi, v);
+        }
+        GLubyte l[16], h[16];
+        _mm_storeu_si128((__m128i *)l, vlo);
+        _mm_storeu_si128((__m128i *)h, vhi);
+        for (int j = 0; j < 16; j++) {
+            lo = MIN(lo, l[j]);
+            hi = MAX(hi, h[j]);
+        }
+    }
+#elif defined(__ARM_NEON__)
+    if (count >= 16) {
+        uint8x16_t vlo = vdupq_n_u8(0xFF), vhi = vdupq_n_u8(0);
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t v = vld1q_u8(src + i);
+            vlo = vminq_u8(vlo, v);
+            vhi = vmaxq_u8(vhi, v);
+        }
+        GLubyte l[16], h[16];
+        vst1q_u8(l, vlo);
+        vst1q_u8(h, vhi);
+        for (int j = 0; j < 16; j++) {
+            lo = MIN(lo, l[j]);
+            hi = MAX(hi, h[j]);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        lo = MIN(lo, src[i]);
+        hi = MAX(hi, src[i]);
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static void index_range_ushort(const GLushort *src, GLsizei count, GLuint *min, GLuint *max) {
+    GLushort lo = 0xFFFF, hi = 0;
+    GLsizei i = 0;
+#if defined(__SSE2__)
+    if (count >= 8) {
+        // SSE2 only has signed 16-bit min/max, so flip the sign bit around them
+        const __m128i bias = _mm_set1_epi16(0x8000);
+        __m128i vlo = _mm_set1_epi16(0x7FFF), vhi = _mm_set1_epi16(0x8000);
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + i)), bias);
+            vlo = _mm_min_epi16(vlo, v);
+            vhi = _mm_max_epi16(vhi, v);
+        }
+        GLushort l[8], h[8];
+        _mm_storeu_si128((__m128i *)l, _mm_xor_si128(vlo, bias));
+        _mm_storeu_si128((__m128i *)h, _mm_xor_si128(vhi, bias));
+        for (int j = 0; j < 8; j++) {
+            lo = MIN(lo, l[j]);
+            hi = MAX(hi, h[j]);
+        }
+    }
+#elif defined(__ARM_NEON__)
+    if (count >= 8) {
+        uint16x8_t vlo = vdupq_n_u16(0xFFFF), vhi = vdupq_n_u16(0);
+        for (; i + 8 <= count; i += 8) {
+            uint16x8_t v = vld1q_u16(src + i);
+            vlo = vminq_u16(vlo, v);
+            vhi = vmaxq_u16(vhi, v);
+        }
+        GLushort l[8], h[8];
+        vst1q_u16(l, vlo);
+        vst1q_u16(h, vhi);
+        for (int j = 0; j < 8; j++) {
+            lo = MIN(lo, l[j]);
+            hi = MAX(hi, h[j]);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        lo = MIN(lo, src[i]);
+        hi = MAX(hi, src[i]);
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static void index_range_uint(const GLuint *src, GLsizei count, GLuint *min, GLuint *max) {
+    GLuint lo = 0xFFFFFFFF, hi = 0;
+    GLsizei i = 0;
+#if defined(__SSE2__)
+    if (count >= 4) {
+        // no unsigned 32-bit compare before SSE4.1, so compare biased values and select
+        const __m128i bias = _mm_set1_epi32(0x80000000);
+        __m128i vlo = _mm_set1_epi32(0x7FFFFFFF), vhi = bias;
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + i)), bias);
+            __m128i lt = _mm_cmplt_epi32(v, vlo);
+            __m128i gt = _mm_cmpgt_epi32(v, vhi);
+            vlo = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vlo));
+            vhi = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vhi));
+        }
+        GLuint l[4], h[4];
+        _mm_storeu_si128((__m128i *)l, _mm_xor_si128(vlo, bias));
+        _mm_storeu_si128((__m128i *)h, _mm_xor_si128(vhi, bias));
+        for (int j = 0; j < 4; j++) {
+            lo = MIN(lo, l[j]);
+            hi = MAX(hi, h[j]);
+        }
+    }
+#elif defined(__ARM_NEON__)
+    if (count >= 4) {
+        uint32x4_t vlo = vdupq_n_u32(0xFFFFFFFF), vhi = vdupq_n_u32(0);
+        for (; i + 4 <= count; i += 4) {
+            uint32x4_t v = vld1q_u32(src + i);
+            vlo = vminq_u32(vlo, v);
+            vhi = vmaxq_u32(vhi, v);
+        }
+        GLuint l[4], h[4];
+        vst1q_u32(l, vlo);
+        vst1q_u32(h, vhi);
+        for (int j = 0; j < 4; j++) {
+            lo = MIN(lo, l[j]);
+            hi = MAX(hi, h[j]);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        lo = MIN(lo, src[i]);
+        hi = MAX(hi, src[i]);
+    }
+    *min = lo;
+    *max = hi;
+}
+
+// finds the lowest and highest index referenced by an element array
+void gl_index_range(const GLvoid *indices, GLenum type, GLsizei count, GLuint *min, GLuint *max) {
+    *min = *max = 0;
+    if (! indices || count <= 0)
+        return;
+
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            index_range_ubyte(indices, count, min, max);
+            break;
+        case GL_UNSIGNED_SHORT:
+            index_range_ushort(indices, count, min, max);
+            break;
+        case GL_UNSIGNED_INT:
+            index_range_uint(indices, count, min, max);
+            break;
+        default:
+            printf("libGL: gl_index_range -> unsupported type %s\n", gl_str(type));
+            break;
     }
-    for (int i = 0; i < count; i++) {
-        indices[i] -= *min;
+}
+
+// converts an element array to GL_UNSIGNED_SHORT, subtracting base from every index
+GLushort *gl_rebase_indices(const GLvoid *indices, GLenum type, GLsizei count, GLuint base) {
+    GLushort *out = malloc(count * sizeof(GLushort));
+    switch (type) {
+        case GL_UNSIGNED_BYTE: {
+            const GLubyte *src = indices;
+            for (int i = 0; i < count; i++)
+                out[i] = src[i] - base;
+            break;
+        }
+        case GL_UNSIGNED_SHORT: {
+            const GLushort *src = indices;
+            for (int i = 0; i < count; i++)
+                out[i] = src[i] - base;
+            break;
+        }
+        case GL_UNSIGNED_INT: {
+            const GLuint *src = indices;
+            for (int i = 0; i < count; i++)
+                out[i] = src[i] - base;
+            break;
+        }
+        default:
+            printf("libGL: gl_rebase_indices -> unsupported type %s\n", gl_str(type));
+            free(out);
+            return NULL;
     }
+    return out;
 }
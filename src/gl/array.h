@@ -10,8 +10,21 @@ GLvoid *gl_copy_array(const GLvoid *src,
                       GLenum to, GLsizei to_width, GLsizei skip, GLsizei count,
                       GLboolean normalize);
 
+// one attribute of an interleaved array, see gl_copy_interleaved
+typedef struct {
+    const GLubyte *src;
+    GLint size;
+    GLenum type;
+    GLsizei width;
+    GLfloat scale;
+    GLfloat *out;
+} gl_attrib_t;
+
+void gl_copy_interleaved(gl_attrib_t *attribs, int n, GLsizei stride, GLsizei skip, GLsizei count, const GLuint *gather);
 GLvoid *gl_copy_pointer(pointer_state_t *ptr, GLsizei width, GLsizei skip, GLsizei count, GLboolean);
-GLfloat *gl_pointer_index(pointer_state_t *ptr, GLint index);
+GLfloat *gl_gather_pointer(pointer_state_t *ptr, GLsizei width, const GLuint *indices, GLsizei count, GLboolean normalize);
+gl_fetch_t gl_pointer_fetch(GLenum type, GLint size, GLboolean normalize);
 GLfloat *copy_eval_double(GLenum target, GLint ustride, GLint uorder, GLint vstride, GLint vorder, const GLdouble *points);
-void normalize_indices(GLushort *indices, GLsizei *max, GLsizei *min, GLsizei count);
+void gl_index_range(const GLvoid *indices, GLenum type, GLsizei count, GLuint *min, GLuint *max);
+GLushort *gl_rebase_indices(const GLvoid *indices, GLenum type, GLsizei count, GLuint base);
 #endif
@@ -1,9 +1,11 @@
 #include "block.h"
+#include "buffer.h"
 #include "gl_helpers.h"
 #include "line.h"
 #include "loader.h"
 #include "matrix.h"
 #include "render.h"
+#include "stream.h"
 #include "texgen.h"
 #include "texture.h"
 
@@ -18,9 +20,14 @@
 struct {
     GLushort *cache;
     uint32_t len;
+    // scratch space for quads that don't start on a multiple of 4
+    GLushort *offset;
+    uint32_t offset_len;
 } q2t = {0};
 
 static void q2t_calc(int len) {
+    // round up to a whole quad so the winding loop can't overrun the cache
+    len = (len + 3) & ~3;
     if (len <= q2t.len)
         return;
 
@@ -44,6 +51,26 @@ static void q2t_calc(int len) {
     }
 }
 
+// returns q2t indices for drawing quads straight from vertex first + count
+// the returned pointer is owned by the cache and must not be freed
+GLushort *bl_q2t_indices(GLint first, GLsizei count) {
+    if (first % 4 == 0) {
+        q2t_calc(first + count);
+        return q2t.cache + (first / 4) * 6;
+    }
+    q2t_calc(count);
+    uint32_t len = count * 1.5;
+    if (len > q2t.offset_len) {
+        free(q2t.offset);
+        q2t.offset = malloc(len * sizeof(GLushort));
+        q2t.offset_len = len;
+    }
+    for (int i = 0; i < len; i++) {
+        q2t.offset[i] = q2t.cache[i] + first;
+    }
+    return q2t.offset;
+}
+
 block_t *bl_new(GLenum mode) {
     block_t *block = calloc(1, sizeof(block_t));
     block->cap = DEFAULT_BLOCK_CAPACITY;
@@ -60,11 +87,15 @@ block_t *bl_new(GLenum mode) {
 }
 
 void bl_free(block_t *block) {
-    free(block->vert);
-    free(block->normal);
-    free(block->color);
+    if (! block->locked) {
+        free(block->vert);
+        free(block->normal);
+        free(block->color);
+    }
     for (int i = 0; i < MAX_TEX; i++) {
         free(block->tex[i]);
+        free(block->texgen[i]);
+        free(block->texgen_key[i]);
     }
     free(block->indices);
     free(block);
@@ -92,8 +123,9 @@ void bl_q2t(block_t *block) {
 
     q2t_calc(block->len);
     if (block->indices) {
-        GLushort *indices = malloc(block->len);
-        for (int i = 0; i < block->len; i++) {
+        uint32_t len = block->len * 1.5;
+        GLushort *indices = malloc(len * sizeof(GLushort));
+        for (int i = 0; i < len; i++) {
             indices[i] = block->indices[q2t.cache[i]];
         }
         free(block->indices);
@@ -136,15 +168,19 @@ void bl_end(block_t *block) {
     }
 
     block->open = false;
+    // indexed blocks set this when their arrays are built
+    if (! block->indices) {
+        block->vert_len = block->len;
+    }
     for (int i = 0; i < MAX_TEX; i++) {
         gltexture_t *bound = state.texture.bound[i];
         if (block->tex[i] && bound) {
             if (bound->width != bound->nwidth || bound->height != bound->nheight) {
-                tex_coord_npot(block->tex[i], block->len, bound->width, bound->height, bound->nwidth, bound->nheight);
+                tex_coord_npot(block->tex[i], block->vert_len, bound->width, bound->height, bound->nwidth, bound->nheight);
             }
             // GL_ARB_texture_rectangle
             if (state.texture.rect_arb[i]) {
-                tex_coord_rect_arb(block->tex[i], block->len, bound->width, bound->height);
+                tex_coord_rect_arb(block->tex[i], block->vert_len, bound->width, bound->height);
             }
         }
     }
@@ -172,7 +208,7 @@ void bl_draw(block_t *block) {
     // TODO: the texture array could exist but be incomplete :(
     for (int i = 0; i < MAX_TEX; i++) {
         if ((pos = block->incomplete.tex[i]) >= 0) {
-            for (int j = 0; j < block->len; j++) {
+            for (int j = 0; j < block->vert_len; j++) {
                 memcpy(block->tex[i] + (2 * j), CURRENT->tex[i], 2 * sizeof(GLfloat));
             }
         }
@@ -194,31 +230,32 @@ void bl_draw(block_t *block) {
     }
 
     // glTexGen
+    GLfloat *coords[MAX_TEX];
     for (int i = 0; i < MAX_TEX; i++) {
-        if (state.enable.texgen_s[i] || state.enable.texgen_t[i]) {
-            gen_tex_coords(block, i);
+        coords[i] = block->tex[i];
+        if (block->vert && (state.enable.texgen_s[i] || state.enable.texgen_t[i])) {
+            // locked blocks come with theirs
+            coords[i] = block->locked ? block->texgen[i] : texgen_coords(block, i);
         }
     }
 
     // copy vertex data for local matrix calculations
     GLfloat *vert, *tex[MAX_TEX] = {0};
 #ifdef LOCAL_MATRIX
-    vert = malloc(block->len * 3 * sizeof(GLfloat));
-    for (int i = 0; i < block->len; i++) {
-        gl_transform_vertex(&vert[i * 3], &block->vert[i * 3]);
-    }
+    vert = malloc(block->vert_len * 3 * sizeof(GLfloat));
+    gl_transform_vertices(vert, block->vert, block->vert_len);
     for (int t = 0; t < MAX_TEX; t++) {
-        if (block->tex[t]) {
-            tex[t] = malloc(block->len * 2 * sizeof(GLfloat));
-            for (int i = 0; i < block->len; i++) {
-                gl_transform_texture(GL_TEXTURE0 + t, &tex[t][i * 2], &block->tex[t][i * 2]);
+        if (coords[t]) {
+            tex[t] = malloc(block->vert_len * 2 * sizeof(GLfloat));
+            for (int i = 0; i < block->vert_len; i++) {
+                gl_transform_texture(GL_TEXTURE0 + t, &tex[t][i * 2], &coords[t][i * 2]);
             }
         }
     }
 #else
     vert = block->vert;
     for (int i = 0; i < MAX_TEX; i++) {
-        tex[i] = block->tex[i];
+        tex[i] = coords[i];
     }
 #endif
 
@@ -226,6 +263,9 @@ void bl_draw(block_t *block) {
     LOAD_GLES(glDrawElements);
 
     glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    // block arrays and indices are in our memory, not the app's buffers
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #ifdef USE_ES2
     if (block->vert) {
         glEnableVertexAttribArray(0);
@@ -233,48 +273,62 @@ void bl_draw(block_t *block) {
     }
     gles_glDrawArrays(block->mode, 0, block->len);
 #else
+    bool stipple = false;
+    // TODO: how do I stipple with texture?
+    // TODO: what about multitexturing?
+    if (! tex[0]) {
+        // TODO: do we need to support GL_LINE_STRIP?
+        // TODO: indexed lines share vertices between segments, so they can't be stippled per vertex
+        if (block->mode == GL_LINES && state.enable.line_stipple && ! block->indices) {
+            stipple = true;
+            glPushAttrib(GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT | GL_TEXTURE_BIT);
+            glEnable(GL_BLEND);
+            glEnable(GL_TEXTURE_2D);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            tex[0] = gen_stipple_tex_coords(vert, block->len);
+            bind_stipple_tex();
+        }
+    }
+
+    // uploads into the stream ring when LIBGL_STREAM is set. the whole draw
+    // is reserved first, so a wrap can't land between two of its arrays
+    GLsizei floats = (vert ? 3 : 0) + (block->normal ? 3 : 0) + (block->color ? 4 : 0);
+    for (int i = 0; i < MAX_TEX; i++) {
+        floats += tex[i] ? 2 : 0;
+    }
+    bool streamed = stream_reserve(block->vert_len * floats * sizeof(GLfloat));
+    if (! streamed) {
+        stream_unbind();
+    }
+    #define array(data, width) \
+        (streamed ? stream_pointer(data, block->vert_len * width * sizeof(GLfloat)) : (data))
     if (vert) {
         glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, vert);
+        glVertexPointer(3, GL_FLOAT, 0, array(vert, 3));
     } else {
         glDisableClientState(GL_VERTEX_ARRAY);
     }
 
     if (block->normal) {
         glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, block->normal);
+        glNormalPointer(GL_FLOAT, 0, array(block->normal, 3));
     } else {
         glDisableClientState(GL_NORMAL_ARRAY);
     }
 
     if (block->color) {
         glEnableClientState(GL_COLOR_ARRAY);
-        glColorPointer(4, GL_FLOAT, 0, block->color);
+        glColorPointer(4, GL_FLOAT, 0, array(block->color, 4));
     } else {
         glDisableClientState(GL_COLOR_ARRAY);
     }
 
-    bool stipple = false;
-    // TODO: how do I stipple with texture?
-    // TODO: what about multitexturing?
-    if (! tex[0]) {
-        // TODO: do we need to support GL_LINE_STRIP?
-        if (block->mode == GL_LINES && state.enable.line_stipple) {
-            stipple = true;
-            glPushAttrib(GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT | GL_TEXTURE_BIT);
-            glEnable(GL_BLEND);
-            glEnable(GL_TEXTURE_2D);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-            tex[0] = gen_stipple_tex_coords(vert, block->len);
-            bind_stipple_tex();
-        }
-    }
     for (int i = 0; i < MAX_TEX; i++) {
         GLuint old = state.texture.client + GL_TEXTURE0;
         if (tex[i]) {
             glClientActiveTexture(GL_TEXTURE0 + i);
             glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-            glTexCoordPointer(2, GL_FLOAT, 0, tex[i]);
+            glTexCoordPointer(2, GL_FLOAT, 0, array(tex[i], 2));
             glClientActiveTexture(old);
         } else if (state.enable.tex_coord_array[i]) {
             glClientActiveTexture(GL_TEXTURE0 + i);
@@ -288,6 +342,11 @@ void bl_draw(block_t *block) {
     if (block->q2t && !indices)
         indices = q2t.cache;
 
+    #undef array
+    stream_unbind();
+    gl_matrix_flush();
+    gl_texture_flush();
+
     if (indices) {
         gles_glDrawElements(block->mode, block->len, GL_UNSIGNED_SHORT, indices);
     } else {
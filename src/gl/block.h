@@ -10,6 +10,7 @@ extern block_t *bl_new(GLenum mode);
 extern void bl_free(block_t *block);
 extern void bl_draw(block_t *block);
 extern void bl_q2t(block_t *block);
+extern GLushort *bl_q2t_indices(GLint first, GLsizei count);
 extern void bl_end(block_t *block);
 
 extern void bl_vertex3f(block_t *block, GLfloat x, GLfloat y, GLfloat z);
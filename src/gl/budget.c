@@ -0,0 +1,454 @@
+#include "budget.h"
+#include "gl_helpers.h"
+#include "loader.h"
+
+/*
+Keeps the textures handed to the driver under a memory budget.
+
+LIBGL_TEXTURE_BUDGET=n  keep at most n KB of textures in the driver. Every
+                        level is also kept on our side, run length encoded,
+                        so textures not bound anywhere can be evicted, and
+                        are uploaded again when they're next bound.
+
+Evictions happen when a texture is bound and at the end of each frame.
+Lower glPrioritizeTextures priorities go first, then the textures bound
+the longest ago. Textures written to by glCopyTexImage2D can't be copied,
+so they're never evicted.
+*/
+
+typedef struct {
+    GLsizei width, height;
+    // compressed levels have no type
+    GLenum format, type;
+    GLuint size;
+    // the pixels run length encoded, or raw while they're being written
+    GLubyte *packed, *raw;
+    GLuint packed_size;
+} budget_level_t;
+
+struct texture_backing {
+    budget_level_t levels[MAX_TEXTURE_LEVELS];
+    // holds pixels we have no copy of
+    bool pinned;
+};
+
+static struct {
+    bool init, enabled, stats;
+    GLuint budget, used, frame;
+    // the one level left raw, so strips don't repack it each time
+    budget_level_t *open;
+    GLubyte *scratch;
+    GLuint scratch_size;
+} budget = {0};
+
+static void budget_init() {
+    if (budget.init)
+        return;
+    budget.init = true;
+    char *env_budget = getenv("LIBGL_TEXTURE_BUDGET");
+    budget.budget = env_budget ? strtoul(env_budget, NULL, 10) * 1024 : 0;
+    budget.enabled = budget.budget > 0;
+    char *env_stats = getenv("LIBGL_TEXSTATS");
+    budget.stats = env_stats && strcmp(env_stats, "1") == 0;
+}
+
+/*
+PackBits: a count byte under 128 is followed by count + 1 literal bytes,
+from 128 up the next byte repeats count - 125 times.
+*/
+static GLuint rle_pack(const GLubyte *src, GLuint size, GLubyte *dst) {
+    GLubyte *out = dst;
+    GLuint i = 0;
+    while (i < size) {
+        GLuint run = 1;
+        while (i + run < size && run < 130 && src[i + run] == src[i]) {
+            run++;
+        }
+        if (run >= 3) {
+            *out++ = run + 125;
+            *out++ = src[i];
+            i += run;
+            continue;
+        }
+        GLuint start = i, count = 0;
+        while (i < size && count < 128) {
+            if (i + 2 < size && src[i] == src[i + 1] && src[i] == src[i + 2]) {
+                break;
+            }
+            i++;
+            count++;
+        }
+        *out++ = count - 1;
+        memcpy(out, src + start, count);
+        out += count;
+    }
+    return out - dst;
+}
+
+static void rle_unpack(const GLubyte *src, GLuint size, GLubyte *dst) {
+    const GLubyte *end = src + size;
+    while (src < end) {
+        GLuint n = *src++;
+        if (n < 128) {
+            memcpy(dst, src, n + 1);
+            src += n + 1;
+            dst += n + 1;
+        } else {
+            memset(dst, *src++, n - 125);
+            dst += n - 125;
+        }
+    }
+}
+
+static void close_level() {
+    budget_level_t *level = budget.open;
+    if (! level) {
+        return;
+    }
+    budget.open = NULL;
+    // the worst case adds a count byte every 128
+    GLubyte *packed = malloc(level->size + level->size / 128 + 1);
+    if (! packed) {
+        return;
+    }
+    level->packed_size = rle_pack(level->raw, level->size, packed);
+    level->packed = realloc(packed, level->packed_size);
+    if (! level->packed) {
+        level->packed = packed;
+    }
+    free(level->raw);
+    level->raw = NULL;
+}
+
+// the level's raw pixels, to write to
+static GLubyte *open_level(budget_level_t *level) {
+    if (budget.open == level) {
+        return level->raw;
+    }
+    close_level();
+    if (! level->raw) {
+        level->raw = malloc(level->size);
+        if (! level->raw) {
+            return NULL;
+        }
+        if (level->packed) {
+            rle_unpack(level->packed, level->packed_size, level->raw);
+        } else {
+            memset(level->raw, 0, level->size);
+        }
+        free(level->packed);
+        level->packed = NULL;
+    }
+    budget.open = level;
+    return level->raw;
+}
+
+static void free_level(budget_level_t *level) {
+    if (budget.open == level) {
+        budget.open = NULL;
+    }
+    free(level->packed);
+    free(level->raw);
+    level->packed = level->raw = NULL;
+}
+
+static void copy_rows(GLubyte *dst, GLsizei dst_stride,
+                      const GLubyte *src, GLsizei row_size,
+                      GLsizei rows, GLint alignment) {
+    GLsizei src_stride = (row_size + alignment - 1) / alignment * alignment;
+    for (GLsizei y = 0; y < rows; y++) {
+        memcpy(dst + y * dst_stride, src + y * src_stride, row_size);
+    }
+}
+
+// respecifies a level, returning it if its pixels should be kept
+static budget_level_t *set_level(gltexture_t *texture, GLint level,
+                                 GLsizei width, GLsizei height,
+                                 GLenum format, GLenum type, GLuint size) {
+    budget_init();
+    if (! texture || level < 0 || level >= MAX_TEXTURE_LEVELS) {
+        return NULL;
+    }
+    struct texture_backing *backing = texture->backing;
+    if (! backing) {
+        backing = texture->backing = calloc(1, sizeof(struct texture_backing));
+        if (! backing) {
+            return NULL;
+        }
+    }
+    budget_level_t *l = &backing->levels[level];
+    free_level(l);
+    texture->size += size - l->size;
+    if (texture->resident) {
+        budget.used += size - l->size;
+    }
+    l->width = width;
+    l->height = height;
+    l->format = format;
+    l->type = type;
+    l->size = size;
+    if (! budget.enabled || backing->pinned || ! size) {
+        return NULL;
+    }
+    return l;
+}
+
+void budget_image(gltexture_t *texture, GLint level,
+                  GLsizei width, GLsizei height,
+                  GLenum format, GLenum type,
+                  const GLvoid *pixels, GLint alignment) {
+    GLsizei row_size = width * gl_pixel_sizeof(format, type);
+    budget_level_t *l = set_level(texture, level, width, height, format, type, row_size * height);
+    if (! l) {
+        return;
+    }
+    GLubyte *raw = open_level(l);
+    if (! raw) {
+        budget_pin(texture);
+    } else if (pixels) {
+        copy_rows(raw, row_size, pixels, row_size, height, alignment);
+    }
+}
+
+void budget_compressed_image(gltexture_t *texture, GLint level,
+                             GLsizei width, GLsizei height,
+                             GLenum format, GLsizei size, const GLvoid *data) {
+    budget_level_t *l = set_level(texture, level, width, height, format, 0, size);
+    if (! l) {
+        return;
+    }
+    GLubyte *raw = open_level(l);
+    if (! raw) {
+        budget_pin(texture);
+    } else {
+        memcpy(raw, data, size);
+    }
+}
+
+void budget_sub_image(gltexture_t *texture, GLint level,
+                      GLint xoffset, GLint yoffset,
+                      GLsizei width, GLsizei height,
+                      GLenum format, GLenum type,
+                      const GLvoid *pixels, GLint alignment) {
+    if (! budget.enabled || ! texture || ! texture->backing || texture->backing->pinned) {
+        return;
+    }
+    if (level < 0 || level >= MAX_TEXTURE_LEVELS) {
+        return;
+    }
+    budget_level_t *l = &texture->backing->levels[level];
+    if (l->format != format || l->type != type ||
+        xoffset < 0 || yoffset < 0 ||
+        xoffset + width > l->width || yoffset + height > l->height) {
+        // not something the copy can follow
+        budget_pin(texture);
+        return;
+    }
+    GLubyte *raw = open_level(l);
+    if (! raw) {
+        budget_pin(texture);
+        return;
+    }
+    GLsizei pixel_size = gl_pixel_sizeof(format, type);
+    GLsizei stride = l->width * pixel_size;
+    copy_rows(raw + yoffset * stride + xoffset * pixel_size, stride,
+              pixels, width * pixel_size, height, alignment);
+}
+
+void budget_pin(gltexture_t *texture) {
+    if (! texture || ! texture->backing) {
+        return;
+    }
+    texture->backing->pinned = true;
+    for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+        free_level(&texture->backing->levels[i]);
+    }
+}
+
+// whether every level is kept on our side
+bool budget_enabled() {
+    budget_init();
+    return budget.enabled;
+}
+
+// the size a level was last specified at, false if it wasn't
+bool budget_level(gltexture_t *texture, GLint level, GLsizei *width, GLsizei *height) {
+    if (! texture || ! texture->backing || level < 0 || level >= MAX_TEXTURE_LEVELS) {
+        return false;
+    }
+    budget_level_t *l = &texture->backing->levels[level];
+    *width = l->width;
+    *height = l->height;
+    return l->size > 0;
+}
+
+// our copy of an uncompressed level, in the format GLES stores it in, or NULL
+const GLvoid *budget_pixels(gltexture_t *texture, GLint level) {
+    if (! budget.enabled || ! texture || ! texture->backing || texture->backing->pinned ||
+        level < 0 || level >= MAX_TEXTURE_LEVELS) {
+        return NULL;
+    }
+    budget_level_t *l = &texture->backing->levels[level];
+    if (! l->size || ! l->type) {
+        return NULL;
+    }
+    return open_level(l);
+}
+
+static bool bound_anywhere(gltexture_t *texture) {
+    for (int i = 0; i < MAX_TEX; i++) {
+        if (state.texture.bound[i] == texture) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool evictable(gltexture_t *texture) {
+    return texture->resident && texture->size && ! texture->pending &&
+           texture->backing && ! texture->backing->pinned &&
+           ! bound_anywhere(texture);
+}
+
+static void evict(gltexture_t *texture) {
+    LOAD_GLES(glBindTexture);
+    LOAD_GLES(glTexImage2D);
+    struct texture_backing *backing = texture->backing;
+    gles_glBindTexture(GL_TEXTURE_2D, texture->texture);
+    for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+        budget_level_t *l = &backing->levels[i];
+        if (budget.open == l) {
+            close_level();
+        }
+        if (l->size) {
+            // the smallest level GLES takes, which frees the old storage
+            GLenum format = l->type ? l->format : GL_RGB;
+            GLenum type = l->type ? l->type : GL_UNSIGNED_BYTE;
+            gles_glTexImage2D(GL_TEXTURE_2D, i, format, 1, 1, 0, format, type, NULL);
+        }
+    }
+    texture->resident = false;
+    budget.used -= texture->size;
+    if (budget.stats) {
+        printf("libGL: texture %u: evicted %u KB, %u of %u KB in use\n",
+               texture->texture, texture->size / 1024, budget.used / 1024, budget.budget / 1024);
+    }
+}
+
+// reuploads an evicted texture, which has to be bound on the active unit
+static void restore(gltexture_t *texture) {
+    LOAD_GLES(glCompressedTexImage2D);
+    LOAD_GLES(glPixelStorei);
+    LOAD_GLES(glTexImage2D);
+    struct texture_backing *backing = texture->backing;
+    for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+        budget_level_t *l = &backing->levels[i];
+        if (! l->size) {
+            continue;
+        }
+        const GLubyte *pixels = l->raw;
+        if (! pixels) {
+            if (l->size > budget.scratch_size) {
+                free(budget.scratch);
+                budget.scratch = malloc(l->size);
+                budget.scratch_size = budget.scratch ? l->size : 0;
+                if (! budget.scratch) {
+                    continue;
+                }
+            }
+            rle_unpack(l->packed, l->packed_size, budget.scratch);
+            pixels = budget.scratch;
+        }
+        if (! l->type) {
+            gles_glCompressedTexImage2D(GL_TEXTURE_2D, i, l->format, l->width, l->height, 0,
+                                        l->size, pixels);
+            continue;
+        }
+        GLsizei stride = l->width * gl_pixel_sizeof(l->format, l->type);
+        bool realign = stride % state.texture.unpack_alignment != 0;
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        }
+        gles_glTexImage2D(GL_TEXTURE_2D, i, l->format, l->width, l->height, 0,
+                          l->format, l->type, pixels);
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, state.texture.unpack_alignment);
+        }
+    }
+    texture->resident = true;
+    budget.used += texture->size;
+    if (budget.stats) {
+        printf("libGL: texture %u: restored %u KB, %u of %u KB in use\n",
+               texture->texture, texture->size / 1024, budget.used / 1024, budget.budget / 1024);
+    }
+}
+
+// lower priorities first, then the least recently bound
+static bool evict_before(gltexture_t *a, gltexture_t *b) {
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    return a->used < b->used;
+}
+
+static void fit_budget() {
+    khash_t(tex) *list = state.texture.list;
+    if (! list) {
+        return;
+    }
+    bool evicted = false;
+    while (budget.used > budget.budget) {
+        gltexture_t *victim = NULL, *tex;
+        kh_foreach_value(list, tex, {
+            if (evictable(tex) && (! victim || evict_before(tex, victim))) {
+                victim = tex;
+            }
+        });
+        if (! victim) {
+            break;
+        }
+        evict(victim);
+        evicted = true;
+    }
+    if (evicted) {
+        gltexture_t *bound = state.texture.bound[state.texture.active];
+        LOAD_GLES(glBindTexture);
+        gles_glBindTexture(GL_TEXTURE_2D, bound ? bound->texture : 0);
+    }
+}
+
+// called when a texture is bound, after the GLES side has it bound
+void budget_use(gltexture_t *texture) {
+    budget_init();
+    if (! budget.enabled) {
+        return;
+    }
+    texture->used = budget.frame;
+    if (! texture->resident) {
+        restore(texture);
+    }
+    fit_budget();
+}
+
+void budget_delete(gltexture_t *texture) {
+    if (texture->resident) {
+        budget.used -= texture->size;
+    }
+    if (texture->backing) {
+        for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+            free_level(&texture->backing->levels[i]);
+        }
+        free(texture->backing);
+        texture->backing = NULL;
+    }
+}
+
+// called once per frame, from glXSwapBuffers
+void budget_frame() {
+    if (! budget.enabled) {
+        return;
+    }
+    budget.frame++;
+    close_level();
+    fit_budget();
+}
@@ -0,0 +1,29 @@
+#include "gl.h"
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include "types.h"
+
+// pixels are rows padded to `alignment`, or NULL for an undefined level
+extern void budget_image(gltexture_t *texture, GLint level,
+                         GLsizei width, GLsizei height,
+                         GLenum format, GLenum type,
+                         const GLvoid *pixels, GLint alignment);
+extern void budget_compressed_image(gltexture_t *texture, GLint level,
+                                    GLsizei width, GLsizei height,
+                                    GLenum format, GLsizei size, const GLvoid *data);
+extern void budget_sub_image(gltexture_t *texture, GLint level,
+                             GLint xoffset, GLint yoffset,
+                             GLsizei width, GLsizei height,
+                             GLenum format, GLenum type,
+                             const GLvoid *pixels, GLint alignment);
+extern void budget_pin(gltexture_t *texture);
+extern bool budget_enabled();
+extern bool budget_level(gltexture_t *texture, GLint level, GLsizei *width, GLsizei *height);
+extern const GLvoid *budget_pixels(gltexture_t *texture, GLint level);
+extern void budget_use(gltexture_t *texture);
+extern void budget_delete(gltexture_t *texture);
+extern void budget_frame();
+
+#endif
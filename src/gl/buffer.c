@@ -0,0 +1,352 @@
+#include "buffer.h"
+#include "error.h"
+#include "loader.h"
+
+/*
+GL_ARB_vertex_buffer_object on top of GLES 1.1 buffers.
+
+Buffer contents live in the driver, so direct draws just reference offsets.
+The paths that read vertex data on the CPU (GL_QUADS conversion, texgen,
+select/feedback, display lists) need a copy of their own, a shadow in memory
+that glMapBuffer also hands out, as GLES 1.1 can't map buffers itself.
+
+Element buffers are always shadowed, the indices are needed to draw GL_QUADS,
+and array buffers are too unless LIBGL_VBO_SHADOW=0. GLES 1.1 can't read a
+buffer back, so without a shadow an array buffer only starts keeping one at
+its next full upload after one of those paths needed it. Until then
+intercepted draws from it go straight to GLES, without what the intercept
+would have added, display lists see no data in it, and glMapBuffer fails
+with GL_INVALID_OPERATION.
+
+LIBGL_VBO_SHADOW=0  only shadow array buffers once they're read on the CPU,
+                    for apps with large buffers that are just drawn.
+*/
+
+static bool shadow_arrays() {
+    static int shadow = -1;
+    if (shadow < 0) {
+        char *env_shadow = getenv("LIBGL_VBO_SHADOW");
+        shadow = ! (env_shadow && strcmp(env_shadow, "0") == 0);
+    }
+    return shadow;
+}
+
+// whether the CPU can read every enabled array, flagging the buffers it can't
+bool gl_arrays_readable() {
+    bool readable = true;
+    #define check(enabled, p) \
+        if ((enabled) && ! gl_pointer_data(p)) readable = false
+    check(state.enable.vertex_array, &state.pointers.vertex);
+    check(state.enable.color_array, &state.pointers.color);
+    check(state.enable.normal_array, &state.pointers.normal);
+    for (int i = 0; i < MAX_TEX; i++) {
+        check(state.enable.tex_coord_array[i], &state.pointers.tex_coord[i]);
+    }
+    #undef check
+    return readable;
+}
+
+static glbuffer_t **buffer_target(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return &state.buffers.array;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &state.buffers.element;
+    }
+    return NULL;
+}
+
+// binds a buffer name on the GLES side, skipping redundant binds
+void gles_buffer_bind(GLenum target, GLuint buffer) {
+    GLuint *bound = (target == GL_ARRAY_BUFFER) ? &state.buffers.gles_array : &state.buffers.gles_element;
+    if (*bound != buffer) {
+        LOAD_GLES(glBindBuffer);
+        gles_glBindBuffer(target, buffer);
+        *bound = buffer;
+    }
+}
+
+// puts the app's bindings back after drawing from our own memory or buffers
+void gles_buffers_restore() {
+    glbuffer_t *array = state.buffers.array, *element = state.buffers.element;
+    gles_buffer_bind(GL_ARRAY_BUFFER, array ? array->buffer : 0);
+    gles_buffer_bind(GL_ELEMENT_ARRAY_BUFFER, element ? element->buffer : 0);
+}
+
+#ifndef USE_ES2
+void glGenBuffers(GLsizei n, GLuint *buffers) {
+    if (n < 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    LOAD_GLES(glGenBuffers);
+    gles_glGenBuffers(n, buffers);
+}
+
+void glBindBuffer(GLenum target, GLuint buffer) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    glbuffer_t *buf = NULL;
+    if (buffer) {
+        int ret;
+        khint_t k;
+        khash_t(buffer) *list = state.buffers.list;
+        if (! list) {
+            list = state.buffers.list = kh_init(buffer);
+            // segfaults if we don't do a single put
+            kh_put(buffer, list, 1, &ret);
+            kh_del(buffer, list, 1);
+        }
+
+        k = kh_get(buffer, list, buffer);
+        if (k == kh_end(list)) {
+            k = kh_put(buffer, list, buffer, &ret);
+            buf = kh_value(list, k) = calloc(1, sizeof(glbuffer_t));
+            buf->buffer = buffer;
+            buf->usage = GL_STATIC_DRAW;
+            buf->access = GL_READ_WRITE;
+        } else {
+            buf = kh_value(list, k);
+        }
+    }
+    *bound = buf;
+    gles_buffer_bind(target, buffer);
+}
+
+// GLES 1.1 only knows about drawing
+static GLenum gles_usage(GLenum usage) {
+    switch (usage) {
+        case GL_STATIC_DRAW:
+        case GL_STATIC_READ:
+        case GL_STATIC_COPY:
+            return GL_STATIC_DRAW;
+        default:
+            return GL_DYNAMIC_DRAW;
+    }
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    if (size < 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf || buf->mapped) {
+        ERROR(GL_INVALID_OPERATION);
+    }
+    buf->usage = usage;
+    buf->size = size;
+    free(buf->shadow);
+    buf->shadow = NULL;
+    if (target == GL_ELEMENT_ARRAY_BUFFER || buf->want_shadow || shadow_arrays()) {
+        buf->shadow = malloc(size);
+        if (data) {
+            memcpy(buf->shadow, data, size);
+        }
+    }
+    gles_buffer_bind(target, buf->buffer);
+    LOAD_GLES(glBufferData);
+    gles_glBufferData(target, size, data, gles_usage(usage));
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf || buf->mapped) {
+        ERROR(GL_INVALID_OPERATION);
+    }
+    if (offset < 0 || size < 0 || offset + size > buf->size) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    // replacing all of it is as good as glBufferData for starting a shadow
+    if (! buf->shadow && buf->want_shadow && offset == 0 && size == buf->size) {
+        buf->shadow = malloc(size);
+    }
+    if (buf->shadow) {
+        memcpy((GLubyte *)buf->shadow + offset, data, size);
+    }
+    gles_buffer_bind(target, buf->buffer);
+    LOAD_GLES(glBufferSubData);
+    gles_glBufferSubData(target, offset, size, data);
+}
+
+void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, GLvoid *data) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf || buf->mapped) {
+        ERROR(GL_INVALID_OPERATION);
+    }
+    if (offset < 0 || size < 0 || offset + size > buf->size) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    if (buf->shadow) {
+        memcpy(data, (GLubyte *)buf->shadow + offset, size);
+    }
+}
+
+// clears every reference to a buffer that's going away
+static void unbind_buffer(glbuffer_t *buf) {
+    if (state.buffers.array == buf) {
+        state.buffers.array = NULL;
+    }
+    if (state.buffers.element == buf) {
+        state.buffers.element = NULL;
+    }
+    if (state.buffers.gles_array == buf->buffer) {
+        state.buffers.gles_array = 0;
+    }
+    if (state.buffers.gles_element == buf->buffer) {
+        state.buffers.gles_element = 0;
+    }
+    pointer_states_t *p = &state.pointers;
+    #define unref(p) if ((p).buffer == buf) { (p).buffer = NULL; (p).pointer = NULL; }
+    unref(p->vertex);
+    unref(p->color);
+    unref(p->normal);
+    for (int i = 0; i < MAX_TEX; i++) {
+        unref(p->tex_coord[i]);
+    }
+    // the locked cache compares pointer states, so it mustn't match a new buffer
+    p = &state.block.arrays.pointers;
+    unref(p->vertex);
+    unref(p->color);
+    unref(p->normal);
+    for (int i = 0; i < MAX_TEX; i++) {
+        unref(p->tex_coord[i]);
+    }
+    #undef unref
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+    if (n < 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    khash_t(buffer) *list = state.buffers.list;
+    if (list) {
+        khint_t k;
+        glbuffer_t *buf;
+        for (int i = 0; i < n; i++) {
+            GLuint b = buffers[i];
+            k = kh_get(buffer, list, b);
+            if (k != kh_end(list)) {
+                buf = kh_value(list, k);
+                unbind_buffer(buf);
+                free(buf->shadow);
+                free(buf);
+                kh_del(buffer, list, k);
+            }
+        }
+    }
+    LOAD_GLES(glDeleteBuffers);
+    gles_glDeleteBuffers(n, buffers);
+}
+
+GLboolean glIsBuffer(GLuint buffer) {
+    khash_t(buffer) *list = state.buffers.list;
+    if (list && buffer) {
+        return kh_get(buffer, list, buffer) != kh_end(list);
+    }
+    return GL_FALSE;
+}
+
+void glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf) {
+        ERROR(GL_INVALID_OPERATION);
+    }
+    switch (pname) {
+        case GL_BUFFER_SIZE:
+            *params = buf->size;
+            break;
+        case GL_BUFFER_USAGE:
+            *params = buf->usage;
+            break;
+        case GL_BUFFER_ACCESS:
+            *params = buf->access;
+            break;
+        case GL_BUFFER_MAPPED:
+            *params = buf->mapped;
+            break;
+        default:
+            ERROR(GL_INVALID_ENUM);
+    }
+}
+
+// params is really a GLvoid **, the wrapper headers declare it as GLvoid *
+void glGetBufferPointerv(GLenum target, GLenum pname, GLvoid *params) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound || pname != GL_BUFFER_MAP_POINTER) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf) {
+        ERROR(GL_INVALID_OPERATION);
+    }
+    *(GLvoid **)params = buf->mapped ? buf->shadow : NULL;
+}
+
+GLvoid *glMapBuffer(GLenum target, GLenum access) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        gl_set_error(GL_INVALID_ENUM);
+        return NULL;
+    }
+    switch (access) {
+        case GL_READ_ONLY:
+        case GL_WRITE_ONLY:
+        case GL_READ_WRITE:
+            break;
+        default:
+            gl_set_error(GL_INVALID_ENUM);
+            return NULL;
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf || buf->mapped) {
+        gl_set_error(GL_INVALID_OPERATION);
+        return NULL;
+    }
+    if (! buf->shadow) {
+        // there's nothing to map the contents from
+        buf->want_shadow = true;
+        gl_set_error(GL_INVALID_OPERATION);
+        return NULL;
+    }
+    buf->mapped = true;
+    buf->access = access;
+    return buf->shadow;
+}
+
+GLboolean glUnmapBuffer(GLenum target) {
+    glbuffer_t **bound = buffer_target(target);
+    if (! bound) {
+        gl_set_error(GL_INVALID_ENUM);
+        return GL_FALSE;
+    }
+    glbuffer_t *buf = *bound;
+    if (! buf || ! buf->mapped) {
+        gl_set_error(GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+    buf->mapped = false;
+    if (buf->access != GL_READ_ONLY) {
+        gles_buffer_bind(target, buf->buffer);
+        LOAD_GLES(glBufferSubData);
+        gles_glBufferSubData(target, 0, buf->size, buf->shadow);
+    }
+    return GL_TRUE;
+}
+#endif
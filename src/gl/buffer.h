@@ -0,0 +1,49 @@
+#include "gl.h"
+
+#ifndef GL_BUFFER_H
+#define GL_BUFFER_H
+
+#include "types.h"
+
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data);
+void glDeleteBuffers(GLsizei n, const GLuint *buffers);
+void glGenBuffers(GLsizei n, GLuint *buffers);
+void glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params);
+void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, GLvoid *data);
+GLboolean glIsBuffer(GLuint buffer);
+GLvoid *glMapBuffer(GLenum target, GLenum access);
+GLboolean glUnmapBuffer(GLenum target);
+
+void gles_buffer_bind(GLenum target, GLuint buffer);
+void gles_buffers_restore();
+void gles_arrays_rebase(GLuint base);
+
+bool gl_arrays_readable();
+
+// where the CPU can read an array: client memory, or its buffer's shadow copy.
+// a buffer without one keeps one from its next upload on
+static inline const GLvoid *gl_pointer_data(const pointer_state_t *p) {
+    if (p->buffer) {
+        if (! p->buffer->shadow) {
+            p->buffer->want_shadow = true;
+            return NULL;
+        }
+        return (const GLubyte *)p->buffer->shadow + (uintptr_t)p->pointer;
+    }
+    return p->pointer;
+}
+
+// same for glDrawElements indices, which are an offset with an element buffer bound
+static inline const GLvoid *gl_element_data(const GLvoid *indices) {
+    glbuffer_t *buffer = state.buffers.element;
+    if (buffer) {
+        if (! buffer->shadow)
+            return NULL;
+        return (const GLubyte *)buffer->shadow + (uintptr_t)indices;
+    }
+    return indices;
+}
+
+#endif
@@ -0,0 +1,437 @@
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "etc1.h"
+#include "pool.h"
+
+/*
+Compresses opaque textures to ETC1 on upload, a sixth of their RGB size.
+
+LIBGL_ETC1=1          encode opaque RGB textures as ETC1
+LIBGL_ETC1_QUALITY=n  0 (default) picks one base color per half block;
+                      1 also tries nearby base colors and both color
+                      modes, at a few times the cost.
+LIBGL_ETC1_CACHE=dir  where encoded textures are kept across runs, keyed by
+                      a hash of their pixels (default
+                      $XDG_CACHE_HOME/glshim/etc1, or ~/.cache/glshim/etc1).
+                      0 turns the cache off.
+*/
+
+static struct {
+    bool init, enabled;
+    int quality;
+    char cache[PATH_MAX];
+} etc1 = {0};
+
+static void etc1_init() {
+    if (etc1.init)
+        return;
+    etc1.init = true;
+    char *env_etc1 = getenv("LIBGL_ETC1");
+    etc1.enabled = env_etc1 && strcmp(env_etc1, "1") == 0;
+    char *env_quality = getenv("LIBGL_ETC1_QUALITY");
+    etc1.quality = env_quality ? strtol(env_quality, NULL, 10) : 0;
+
+    char *env_cache = getenv("LIBGL_ETC1_CACHE");
+    char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+    int length = 0;
+    if (env_cache) {
+        if (strcmp(env_cache, "0") != 0) {
+            length = snprintf(etc1.cache, PATH_MAX, "%s", env_cache);
+        }
+    } else if (xdg && *xdg) {
+        length = snprintf(etc1.cache, PATH_MAX, "%s/glshim/etc1", xdg);
+    } else if (home && *home) {
+        length = snprintf(etc1.cache, PATH_MAX, "%s/.cache/glshim/etc1", home);
+    }
+    // a path that doesn't fit turns the cache off
+    if (length >= PATH_MAX) {
+        *etc1.cache = '\0';
+    }
+}
+
+bool etc1_enabled() {
+    etc1_init();
+    return etc1.enabled;
+}
+
+GLsizei etc1_size(GLsizei width, GLsizei height) {
+    return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+// the pixel index picks one of these, added to each channel of the base color
+static const int modifiers[8][4] = {
+    { 2,   8,  -2,   -8},
+    { 5,  17,  -5,  -17},
+    { 9,  29,  -9,  -29},
+    {13,  42, -13,  -42},
+    {18,  60, -18,  -60},
+    {24,  80, -24,  -80},
+    {33, 106, -33, -106},
+    {47, 183, -47, -183},
+};
+
+static inline int clamp255(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// a block is 16 RGB pixels, indexed y * 4 + x
+typedef GLubyte etc1_block_t[16][3];
+
+// the pixels of half a block; flipped blocks split top and bottom instead of left and right
+static void half_pixels(bool flip, int half, int pixels[8]) {
+    for (int i = 0; i < 8; i++) {
+        int x, y;
+        if (flip) {
+            x = i % 4;
+            y = half * 2 + i / 4;
+        } else {
+            x = half * 2 + i / 4;
+            y = i % 4;
+        }
+        pixels[i] = y * 4 + x;
+    }
+}
+
+// the best table and indices for half a block around a base color, returns the error
+static GLuint fit_half(etc1_block_t block, const int pixels[8], const int base[3],
+                       int *table, GLubyte indices[16], GLuint limit) {
+    GLuint best = limit;
+    for (int t = 0; t < 8; t++) {
+        GLubyte picked[8];
+        GLuint error = 0;
+        for (int i = 0; i < 8 && error < best; i++) {
+            const GLubyte *p = block[pixels[i]];
+            GLuint closest = UINT_MAX;
+            for (int m = 0; m < 4; m++) {
+                int mod = modifiers[t][m];
+                int r = clamp255(base[0] + mod) - p[0];
+                int g = clamp255(base[1] + mod) - p[1];
+                int b = clamp255(base[2] + mod) - p[2];
+                GLuint e = r * r + g * g + b * b;
+                if (e < closest) {
+                    closest = e;
+                    picked[i] = m;
+                }
+            }
+            error += closest;
+        }
+        if (error < best) {
+            best = error;
+            *table = t;
+            for (int i = 0; i < 8; i++) {
+                indices[pixels[i]] = picked[i];
+            }
+        }
+    }
+    return best;
+}
+
+// expands quantized colors of 4 or 5 bits
+static void expand(const int q[3], int bits, int base[3]) {
+    for (int c = 0; c < 3; c++) {
+        base[c] = bits == 4 ? (q[c] << 4) | q[c] : (q[c] << 3) | (q[c] >> 2);
+    }
+}
+
+typedef struct {
+    GLuint error;
+    bool diff, flip;
+    int q[2][3], table[2];
+    GLubyte indices[16];
+} encoding_t;
+
+// fits both halves with the given base colors, keeping it in best if it's better
+static void try_encoding(etc1_block_t block, bool flip, bool diff, const int q[2][3], encoding_t *best) {
+    int bits = diff ? 5 : 4, max = (1 << bits) - 1;
+    for (int c = 0; c < 3; c++) {
+        for (int h = 0; h < 2; h++) {
+            if (q[h][c] < 0 || q[h][c] > max) {
+                return;
+            }
+        }
+        if (diff && (q[1][c] - q[0][c] < -4 || q[1][c] - q[0][c] > 3)) {
+            return;
+        }
+    }
+    encoding_t e = {.diff = diff, .flip = flip};
+    memcpy(e.q, q, sizeof(e.q));
+    for (int h = 0; h < 2 && e.error < best->error; h++) {
+        int pixels[8], base[3];
+        half_pixels(flip, h, pixels);
+        expand(q[h], bits, base);
+        e.error += fit_half(block, pixels, base, &e.table[h], e.indices, best->error - e.error);
+    }
+    if (e.error < best->error) {
+        *best = e;
+    }
+}
+
+static void encode_block(etc1_block_t block, int quality, GLubyte out[8]) {
+    encoding_t best = {.error = UINT_MAX};
+    for (int flip = 0; flip < 2; flip++) {
+        // the average color of each half, quantized to 5 and 4 bits
+        int q5[2][3], q4[2][3];
+        for (int h = 0; h < 2; h++) {
+            int pixels[8], sum[3] = {0};
+            half_pixels(flip, h, pixels);
+            for (int i = 0; i < 8; i++) {
+                for (int c = 0; c < 3; c++) {
+                    sum[c] += block[pixels[i]][c];
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                q5[h][c] = (sum[c] * 31 + 8 * 255 / 2) / (8 * 255);
+                q4[h][c] = (sum[c] * 15 + 8 * 255 / 2) / (8 * 255);
+            }
+        }
+        try_encoding(block, flip, true, q5, &best);
+        if (quality > 0 || best.error == UINT_MAX) {
+            try_encoding(block, flip, false, q4, &best);
+        }
+        if (quality > 0) {
+            // nudge each half's base color along the grey axis
+            for (int d0 = -1; d0 <= 1; d0++) {
+                for (int d1 = -1; d1 <= 1; d1++) {
+                    int q[2][3];
+                    for (int c = 0; c < 3; c++) {
+                        q[0][c] = q5[0][c] + d0;
+                        q[1][c] = q5[1][c] + d1;
+                    }
+                    try_encoding(block, flip, true, q, &best);
+                    for (int c = 0; c < 3; c++) {
+                        q[0][c] = q4[0][c] + d0;
+                        q[1][c] = q4[1][c] + d1;
+                    }
+                    try_encoding(block, flip, false, q, &best);
+                }
+            }
+        }
+    }
+
+    GLuint high = 0, low = 0;
+    for (int c = 0; c < 3; c++) {
+        int shift = 24 - c * 8;
+        if (best.diff) {
+            high |= best.q[0][c] << (shift + 3);
+            high |= ((best.q[1][c] - best.q[0][c]) & 7) << shift;
+        } else {
+            high |= best.q[0][c] << (shift + 4);
+            high |= best.q[1][c] << shift;
+        }
+    }
+    high |= best.table[0] << 5 | best.table[1] << 2 | best.diff << 1 | best.flip;
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int bit = x * 4 + y, index = best.indices[y * 4 + x];
+            low |= ((index >> 1) << (bit + 16)) | ((index & 1) << bit);
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        out[i] = high >> (24 - i * 8);
+        out[i + 4] = low >> (24 - i * 8);
+    }
+}
+
+static void decode_block(const GLubyte in[8], etc1_block_t block) {
+    GLuint high = in[0] << 24 | in[1] << 16 | in[2] << 8 | in[3];
+    GLuint low = in[4] << 24 | in[5] << 16 | in[6] << 8 | in[7];
+    bool diff = high & 2, flip = high & 1;
+    int base[2][3], q[2][3];
+    for (int c = 0; c < 3; c++) {
+        int shift = 24 - c * 8;
+        if (diff) {
+            int delta = (high >> shift) & 7;
+            q[0][c] = (high >> (shift + 3)) & 31;
+            q[1][c] = q[0][c] + (delta > 3 ? delta - 8 : delta);
+        } else {
+            q[0][c] = (high >> (shift + 4)) & 15;
+            q[1][c] = (high >> shift) & 15;
+        }
+    }
+    expand(q[0], diff ? 5 : 4, base[0]);
+    expand(q[1], diff ? 5 : 4, base[1]);
+    int tables[2] = {(high >> 5) & 7, (high >> 2) & 7};
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int bit = x * 4 + y;
+            int index = ((low >> (bit + 16)) & 1) << 1 | ((low >> bit) & 1);
+            int half = flip ? y / 2 : x / 2;
+            int mod = modifiers[tables[half]][index];
+            for (int c = 0; c < 3; c++) {
+                block[y * 4 + x][c] = clamp255(base[half][c] + mod);
+            }
+        }
+    }
+}
+
+typedef struct {
+    const GLubyte *rgb;
+    GLubyte *etc1;
+    GLsizei width, height, blocks_x, blocks_y;
+} encode_job_t;
+
+// encodes one band of block rows
+static void encode_band(void *arg, int index, int count) {
+    encode_job_t *job = arg;
+    GLsizei first = job->blocks_y * index / count, last = job->blocks_y * (index + 1) / count;
+    for (GLsizei by = first; by < last; by++) {
+        for (GLsizei bx = 0; bx < job->blocks_x; bx++) {
+            etc1_block_t block;
+            // edge blocks repeat the last row and column
+            for (int y = 0; y < 4; y++) {
+                GLsizei sy = by * 4 + y < job->height ? by * 4 + y : job->height - 1;
+                for (int x = 0; x < 4; x++) {
+                    GLsizei sx = bx * 4 + x < job->width ? bx * 4 + x : job->width - 1;
+                    memcpy(block[y * 4 + x], job->rgb + (sy * job->width + sx) * 3, 3);
+                }
+            }
+            encode_block(block, etc1.quality, job->etc1 + (by * job->blocks_x + bx) * 8);
+        }
+    }
+}
+
+// the cache key, eight bytes at a time through the murmur3 finalizer
+static uint64_t hash_pixels(const GLubyte *data, GLsizei size, uint64_t hash) {
+    GLsizei i = 0;
+    for (; i < size; i += 8) {
+        uint64_t word = 0;
+        memcpy(&word, data + i, i + 8 <= size ? 8 : size - i);
+        hash ^= word;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+    }
+    return hash;
+}
+
+// FNV-1a, a second opinion stored in the file to catch key collisions
+static uint64_t check_pixels(const GLubyte *data, GLsizei size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (GLsizei i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// cache files start with this, and are only used when it matches
+typedef struct {
+    char magic[4];
+    GLuint width, height, quality;
+    uint64_t check;
+} cache_header_t;
+
+// makes every missing directory in the cache path
+static bool make_cache_dir() {
+    char path[PATH_MAX];
+    snprintf(path, PATH_MAX, "%s", etc1.cache);
+    for (char *p = path + 1; ; p++) {
+        if (*p == '/' || ! *p) {
+            char end = *p;
+            *p = '\0';
+            if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+            if (! end) {
+                return true;
+            }
+            *p = end;
+        }
+    }
+}
+
+static bool cache_load(const char *path, const cache_header_t *header,
+                       GLubyte *out, GLsizei size) {
+    FILE *fd = fopen(path, "rb");
+    if (! fd) {
+        return false;
+    }
+    cache_header_t stored;
+    bool ok = fread(&stored, sizeof(stored), 1, fd) == 1 &&
+              memcmp(&stored, header, sizeof(stored)) == 0 &&
+              fread(out, 1, size, fd) == size && fgetc(fd) == EOF;
+    fclose(fd);
+    return ok;
+}
+
+static void cache_store(const char *path, const cache_header_t *header,
+                        const GLubyte *data, GLsizei size) {
+    if (! make_cache_dir()) {
+        return;
+    }
+    // written aside and renamed, so another process never reads half a file
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, PATH_MAX, "%s.%d", path, (int)getpid()) >= PATH_MAX) {
+        return;
+    }
+    FILE *fd = fopen(tmp, "wb");
+    if (! fd) {
+        return;
+    }
+    bool ok = fwrite(header, sizeof(*header), 1, fd) == 1 &&
+              fwrite(data, 1, size, fd) == size;
+    ok = (fclose(fd) == 0) && ok;
+    if (! ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+    }
+}
+
+void etc1_encode(const GLubyte *rgb, GLsizei width, GLsizei height, GLubyte *out) {
+    etc1_init();
+    encode_job_t job = {
+        .rgb = rgb,
+        .etc1 = out,
+        .width = width,
+        .height = height,
+        .blocks_x = (width + 3) / 4,
+        .blocks_y = (height + 3) / 4,
+    };
+    GLsizei size = etc1_size(width, height);
+    char path[PATH_MAX] = {0};
+    cache_header_t header = {
+        .magic = {'E', 'T', 'C', '1'},
+        .width = width,
+        .height = height,
+        .quality = etc1.quality,
+    };
+    if (*etc1.cache) {
+        // the size and quality are part of the key, a 1x4 image isn't a 4x1 one
+        GLuint key[3] = {width, height, etc1.quality};
+        uint64_t hash = hash_pixels((const GLubyte *)key, sizeof(key), 0);
+        hash = hash_pixels(rgb, width * height * 3, hash);
+        header.check = check_pixels(rgb, width * height * 3);
+        if (snprintf(path, PATH_MAX, "%s/%016llx.etc1", etc1.cache,
+                     (unsigned long long)hash) >= PATH_MAX) {
+            *path = '\0';
+        } else if (cache_load(path, &header, out, size)) {
+            return;
+        }
+    }
+    int bands = 1;
+    if (width * height * 3 >= TEXTURE_THREAD_SIZE) {
+        bands = pool_threads();
+    }
+    pool_run(encode_band, &job, bands < job.blocks_y ? bands : job.blocks_y);
+    if (*path) {
+        cache_store(path, &header, out, size);
+    }
+}
+
+void etc1_decode(const GLubyte *in, GLsizei width, GLsizei height, GLubyte *rgb) {
+    GLsizei blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    for (GLsizei by = 0; by < blocks_y; by++) {
+        for (GLsizei bx = 0; bx < blocks_x; bx++) {
+            etc1_block_t block;
+            decode_block(in + (by * blocks_x + bx) * 8, block);
+            for (int y = 0; y < 4 && by * 4 + y < height; y++) {
+                for (int x = 0; x < 4 && bx * 4 + x < width; x++) {
+                    memcpy(rgb + ((by * 4 + y) * width + bx * 4 + x) * 3, block[y * 4 + x], 3);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#include "gl.h"
+
+#ifndef ETC1_H
+#define ETC1_H
+
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+extern bool etc1_enabled();
+extern GLsizei etc1_size(GLsizei width, GLsizei height);
+// rgb is tightly packed GL_RGB GL_UNSIGNED_BYTE rows
+extern void etc1_encode(const GLubyte *rgb, GLsizei width, GLsizei height, GLubyte *etc1);
+extern void etc1_decode(const GLubyte *etc1, GLsizei width, GLsizei height, GLubyte *rgb);
+
+#endif
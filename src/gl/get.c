@@ -50,7 +50,7 @@ const GLubyte *glGetString(GLenum name) {
         case GL_EXTENSIONS:
             return (const GLubyte *)(char *){
 #ifndef USE_ES2
-                // "GL_ARB_vertex_buffer_object "
+                "GL_ARB_vertex_buffer_object "
                 "GL_ARB_multitexture "
                 "GL_ARB_texture_cube_map "
                 "GL_EXT_secondary_color "
@@ -74,6 +74,28 @@ const GLubyte *glGetString(GLenum name) {
     }
 }
 
+// checks the GLES driver's own extension string (not the one we advertise)
+bool gl_driver_extension(const char *name) {
+    static char *extensions = NULL;
+    if (! extensions) {
+        LOAD_GLES(glGetString);
+        const char *ext = (const char *)gles_glGetString(GL_EXTENSIONS);
+        if (! ext) {
+            return false;
+        }
+        extensions = malloc(strlen(ext) + 1);
+        strcpy(extensions, ext);
+    }
+    // only match whole extension names
+    size_t len = strlen(name);
+    for (const char *pos = extensions; (pos = strstr(pos, name)); pos += len) {
+        if ((pos == extensions || pos[-1] == ' ') && (pos[len] == ' ' || pos[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static void gl_get(GLenum pname, GLenum type, GLvoid *params) {
     LOAD_GLES(glGetBooleanv);
     LOAD_GLES(glGetFloatv);
@@ -206,6 +228,7 @@ static void gl_get(GLenum pname, GLenum type, GLvoid *params) {
         case GL_MAX_NAME_STACK_DEPTH:
         case GL_MAX_PROJECTION_STACK_DEPTH:
         case GL_MAX_TEXTURE_STACK_DEPTH:
+        case GL_MATRIX_MODE:
         case GL_MODELVIEW_STACK_DEPTH:
         case GL_NAME_STACK_DEPTH:
         case GL_PROJECTION_STACK_DEPTH:
@@ -230,24 +253,30 @@ static void gl_get(GLenum pname, GLenum type, GLvoid *params) {
                 case GL_MAX_CLIENT_ATTRIB_STACK_DEPTH:
                 case GL_MAX_ELEMENTS_INDICES:
                 case GL_MAX_LIST_NESTING:
-                case GL_MAX_MODELVIEW_STACK_DEPTH:
                 case GL_MAX_NAME_STACK_DEPTH:
-                case GL_MAX_PROJECTION_STACK_DEPTH:
-                case GL_MAX_TEXTURE_STACK_DEPTH:
                     // NOTE: GL_MAX_ELEMENTS_INDICES is *actually* 65535, the others in this group are arbitrary
                     *out = 65535;
                     break;
+                case GL_MAX_MODELVIEW_STACK_DEPTH:
+                case GL_MAX_PROJECTION_STACK_DEPTH:
+                case GL_MAX_TEXTURE_STACK_DEPTH:
+                    *out = MAX_MATRIX_STACK_DEPTH;
+                    break;
+                case GL_MATRIX_MODE:
+                    // GLES only sees the mode when matrices are uploaded
+                    *out = state.matrix.mode;
+                    break;
                 case GL_MODELVIEW_STACK_DEPTH:
-                    *out = tack_len(&state.matrix.model.stack);
+                    *out = state.matrix.model.depth + 1;
                     break;
                 case GL_NAME_STACK_DEPTH:
                     *out = tack_len(&state.select.names);
                     break;
                 case GL_PROJECTION_STACK_DEPTH:
-                    *out = tack_len(&state.matrix.projection.stack);
+                    *out = state.matrix.projection.depth + 1;
                     break;
                 case GL_TEXTURE_STACK_DEPTH:
-                    *out = tack_len(&state.matrix.texture[state.texture.active].stack);
+                    *out = state.matrix.texture[state.texture.active].depth + 1;
                     break;
             }
             if (type != GL_INT) {
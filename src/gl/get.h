@@ -1,4 +1,6 @@
 #include <GL/gl.h>
+#include <stdbool.h>
 
 GLenum gl_get_error();
 void gl_set_error(GLenum error);
+bool gl_driver_extension(const char *name);
@@ -1,8 +1,12 @@
 #include "array.h"
 #include "block.h"
+#include "buffer.h"
 #include "error.h"
 #include "list.h"
 #include "loader.h"
+#include "matrix.h"
+#include "stream.h"
+#include "texgen.h"
 #include "texture.h"
 #include "types.h"
 
@@ -15,6 +19,7 @@ glstate_t state = {
     },
     .matrix = {
         .mode = GL_MODELVIEW,
+        .gles_mode = GL_MODELVIEW,
     },
     .render = {
         .mode = GL_RENDER,
@@ -37,6 +42,9 @@ glstate_t state = {
         .Sv = {1, 0, 0, 0},
         .Tv = {0, 1, 0, 0},
     }},
+    .texture = {
+        .unpack_alignment = 4,
+    },
 };
 
 static void proxy_glEnable(GLenum cap, bool enable, void (*next)(GLenum)) {
@@ -125,30 +133,227 @@ GLboolean glIsEnabled(GLenum cap) {
     }
 }
 
-static block_t *block_from_arrays(GLenum mode, GLsizei skip, GLsizei count) {
+// fills `attribs` with the enabled arrays and allocates their block arrays if
+// they're interleaved in one block of memory, like glInterleavedArrays sets
+// up. returns how many there are, or 0 if they should be copied one by one.
+static int interleaved_attribs(block_t *block, GLsizei count, gl_attrib_t *attribs, GLsizei *stride) {
+    struct {
+        pointer_state_t *p;
+        GLboolean enabled;
+        GLsizei width;
+        GLboolean normalize;
+        GLfloat **out;
+    } arrays[3 + MAX_TEX] = {
+        {&state.pointers.vertex, state.enable.vertex_array, 3, false, &block->vert},
+        {&state.pointers.color, state.enable.color_array, 4, true, &block->color},
+        {&state.pointers.normal, state.enable.normal_array, 3, false, &block->normal},
+    };
+    for (int i = 0; i < MAX_TEX; i++) {
+        arrays[3 + i].p = &state.pointers.tex_coord[i];
+        arrays[3 + i].enabled = state.enable.tex_coord_array[i];
+        arrays[3 + i].width = 2;
+        arrays[3 + i].normalize = false;
+        arrays[3 + i].out = &block->tex[i];
+    }
+
+    GLfloat **outs[3 + MAX_TEX];
+    const GLubyte *lo = NULL, *hi = NULL;
+    int n = 0;
+    for (int i = 0; i < 3 + MAX_TEX; i++) {
+        pointer_state_t *p = arrays[i].p;
+        if (! arrays[i].enabled) {
+            continue;
+        }
+        const GLubyte *data = gl_pointer_data(p);
+        if (! data || (p->type != GL_FLOAT && p->type != GL_UNSIGNED_BYTE) ||
+            (n && p->real_stride != *stride)) {
+            return 0;
+        }
+        const GLubyte *end = data + p->size * gl_sizeof(p->type);
+        lo = (n && lo < data) ? lo : data;
+        hi = (n && hi > end) ? hi : end;
+        *stride = p->real_stride;
+        gl_attrib_t *attrib = &attribs[n];
+        attrib->src = data;
+        attrib->size = p->size;
+        attrib->type = p->type;
+        attrib->width = arrays[i].width;
+        attrib->scale = (arrays[i].normalize && p->type == GL_UNSIGNED_BYTE) ? 1.0f / 255.0f : 1.0f;
+        outs[n++] = arrays[i].out;
+    }
+    if (n < 2 || hi - lo > *stride) {
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        attribs[i].out = *outs[i] = malloc(count * attribs[i].width * sizeof(GLfloat));
+    }
+    return n;
+}
+
+// copies the enabled client arrays into a new block, either `count` vertices
+// starting at `skip`, or the `count` vertices named by `gather` if it's set
+static block_t *block_from_pointers(GLenum mode, GLsizei skip, GLsizei count, const GLuint *gather) {
     block_t *block = bl_new(mode);
     block->artificial = true;
 
     block->len = count;
     block->cap = count;
+    block->vert_len = count;
+    if (count > 0) {
+        gl_attrib_t attribs[3 + MAX_TEX];
+        GLsizei stride;
+        int n = interleaved_attribs(block, count, attribs, &stride);
+        if (n) {
+            gl_copy_interleaved(attribs, n, stride, skip, count, gather);
+            return block;
+        }
+    }
+    #define copy(p, width, normalize) \
+        (gather ? gl_gather_pointer(p, width, gather, count, normalize) \
+                : gl_copy_pointer(p, width, skip, count, normalize))
+
     if (state.enable.vertex_array) {
-        block->vert = gl_copy_pointer(&state.pointers.vertex, 3, skip, count, false);
+        block->vert = copy(&state.pointers.vertex, 3, false);
     }
     if (state.enable.color_array) {
-        block->color = gl_copy_pointer(&state.pointers.color, 4, skip, count, true);
+        block->color = copy(&state.pointers.color, 4, true);
     }
     if (state.enable.normal_array) {
-        block->normal = gl_copy_pointer(&state.pointers.normal, 3, skip, count, false);
+        block->normal = copy(&state.pointers.normal, 3, false);
     }
     for (int i = 0; i < MAX_TEX; i++) {
         if (state.enable.tex_coord_array[i]) {
-            block->tex[i] = gl_copy_pointer(&state.pointers.tex_coord[i], 2, skip, count, false);
+            block->tex[i] = copy(&state.pointers.tex_coord[i], 2, false);
         }
     }
+    #undef copy
     return block;
 }
 
-static inline bool should_intercept_render(GLenum mode) {
+static block_t *block_from_arrays(GLenum mode, GLsizei skip, GLsizei count) {
+    return block_from_pointers(mode, skip, count, NULL);
+}
+
+// converts one array of the locked range, unless it's cached from the same pointer
+static GLfloat *locked_array(GLfloat **cache, pointer_state_t *from, pointer_state_t *p, GLsizei width, GLboolean normalize) {
+    locked_arrays_t *locked = &state.block.arrays;
+    if (! *cache || memcmp(from, p, sizeof(pointer_state_t))) {
+        free(*cache);
+        *cache = gl_copy_pointer(p, width, locked->first, locked->count, normalize);
+        *from = *p;
+        if (cache == &locked->vert || cache == &locked->normal) {
+            locked->version++;
+        }
+    }
+    return *cache;
+}
+
+// glTexGen output for the whole locked range, redone only when its inputs change
+static GLfloat *locked_texgen(GLuint unit) {
+    locked_arrays_t *locked = &state.block.arrays;
+    block_t tmp = {0};
+    tmp.vert = locked->vert;
+    tmp.normal = state.enable.normal_array ? locked->normal : NULL;
+    tmp.vert_len = locked->count;
+    texgen_key_t key;
+    texgen_key(&key, &tmp, unit);
+
+    if (! locked->texgen[unit].coords || locked->texgen[unit].version != locked->version ||
+        ! texgen_key_match(&locked->texgen[unit].key, &key)) {
+        // the range doesn't change while locked, so the old coords are reused
+        tmp.texgen[unit] = locked->texgen[unit].coords;
+        locked->texgen[unit].coords = gen_tex_coords(&tmp, unit);
+        locked->texgen[unit].key = key;
+        locked->texgen[unit].version = locked->version;
+    }
+    return locked->texgen[unit].coords;
+}
+
+// builds a block for `count` vertices at `first` that reuses the locked arrays,
+// or returns NULL if they aren't locked over that range
+static block_t *block_from_locked(GLenum mode, GLint first, GLsizei count) {
+    locked_arrays_t *locked = &state.block.arrays;
+    if (! state.block.locked || state.list.active ||
+        first < locked->first || first + count > locked->first + locked->count) {
+        return NULL;
+    }
+    GLsizei skip = first - locked->first;
+    block_t *block = bl_new(mode);
+    block->artificial = true;
+    block->locked = true;
+    block->len = count;
+    block->cap = count;
+    block->vert_len = count;
+
+    pointer_states_t *p = &state.pointers, *from = &locked->pointers;
+    if (state.enable.vertex_array) {
+        block->vert = locked_array(&locked->vert, &from->vertex, &p->vertex, 3, false) + skip * 3;
+    }
+    if (state.enable.color_array) {
+        block->color = locked_array(&locked->color, &from->color, &p->color, 4, true) + skip * 4;
+    }
+    if (state.enable.normal_array) {
+        block->normal = locked_array(&locked->normal, &from->normal, &p->normal, 3, false) + skip * 3;
+    }
+    for (int i = 0; i < MAX_TEX; i++) {
+        if (block->vert && (state.enable.texgen_s[i] || state.enable.texgen_t[i])) {
+            // generated coords go where bl_draw expects them, past the npot fixup
+            block->texgen[i] = malloc(count * 2 * sizeof(GLfloat));
+            memcpy(block->texgen[i], locked_texgen(i) + skip * 2, count * 2 * sizeof(GLfloat));
+        } else if (state.enable.tex_coord_array[i]) {
+            // texcoords get adjusted in place for npot textures, so the block needs its own
+            GLfloat *tex = locked_array(&locked->tex[i], &from->tex_coord[i], &p->tex_coord[i], 2, false);
+            block->tex[i] = malloc(count * 2 * sizeof(GLfloat));
+            memcpy(block->tex[i], tex + skip * 2, count * 2 * sizeof(GLfloat));
+        }
+    }
+    return block;
+}
+
+// builds a block for glDrawElements. indices are kept (rebased to the lowest one)
+// when the referenced vertices are dense and fit in 16 bits, otherwise the
+// vertices are gathered in index order. `range` is the index range if known.
+static block_t *block_from_elements(GLenum mode, GLsizei count, GLenum type, const GLvoid *uindices, const GLuint *range) {
+    GLuint min, max;
+    if (range) {
+        min = range[0];
+        max = range[1];
+    } else {
+        gl_index_range(uindices, type, count, &min, &max);
+    }
+    GLuint span = max - min + 1;
+    // stipple walks the vertex list in pairs, so lines can't share vertices
+    bool stipple = (mode == GL_LINES && state.enable.line_stipple);
+    locked_arrays_t *locked = &state.block.arrays;
+    if (count > 0 && locked->count <= 65536 && ! stipple &&
+        min >= locked->first && max < locked->first + locked->count) {
+        block_t *block = block_from_locked(mode, locked->first, locked->count);
+        if (block) {
+            block->indices = gl_rebase_indices(uindices, type, count, locked->first);
+            block->len = count;
+            return block;
+        }
+    }
+    if (count > 0 && span <= 65536 && span <= count && ! stipple) {
+        block_t *block = block_from_arrays(mode, min, span);
+        block->indices = gl_rebase_indices(uindices, type, count, min);
+        block->len = count;
+        return block;
+    }
+
+    GLuint *indices = (GLuint *)uindices;
+    if (type != GL_UNSIGNED_INT) {
+        indices = gl_copy_array(uindices, type, 1, 0, GL_UNSIGNED_INT, 1, 0, count, false);
+    }
+    block_t *block = block_from_pointers(mode, 0, count, indices);
+    if (indices != uindices) {
+        free(indices);
+    }
+    return block;
+}
+
+// everything except the primitive type that stops us handing arrays to GLES
+static inline bool should_intercept_state(GLenum mode) {
 #ifdef LOCAL_MATRIX
     // gotta force this for matrix stack
     return true;
@@ -162,47 +367,465 @@ static inline bool should_intercept_render(GLenum mode) {
         (state.enable.vertex_array && ! gl_valid_vertex_type(state.pointers.vertex.type)) ||
         (texgen_enabled) ||
         (mode == GL_LINES && state.enable.line_stipple) ||
-        (mode == GL_QUADS) ||
         (state.render.mode == GL_FEEDBACK || state.render.mode == GL_SELECT)
     );
 }
 
-void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *uindices) {
-    // TODO: split for count > 65535?
-    GLushort *indices = gl_copy_array(uindices, type, 1, 0, GL_UNSIGNED_SHORT, 1, 0, count, false);
-    // TODO: do this in a more direct fashion.
-    if (should_intercept_render(mode)) {
-        glBegin(mode);
-        state.block.active->artificial = true;
-        for (int i = 0; i < count; i++) {
-            glArrayElement(indices[i]);
+static inline bool should_intercept_render(GLenum mode) {
+    return (mode == GL_QUADS) || should_intercept_state(mode);
+}
+
+// checks whether every enabled client array is already in a format GLES accepts
+static bool gles_arrays_valid() {
+    pointer_state_t *p = &state.pointers.color;
+    if (state.enable.color_array && (p->size != 4 || ! gl_valid_color_type(p->type))) {
+        return false;
+    }
+    p = &state.pointers.normal;
+    if (state.enable.normal_array && ! gl_valid_vertex_type(p->type)) {
+        return false;
+    }
+    for (int i = 0; i < MAX_TEX; i++) {
+        p = &state.pointers.tex_coord[i];
+        if (state.enable.tex_coord_array[i]) {
+            if (p->size < 2 || ! gl_valid_vertex_type(p->type) || state.texture.rect_arb[i]) {
+                return false;
+            }
         }
-        glEnd();
-        free(indices);
-        return;
     }
+    return true;
+}
 
+static void draw_elements_intercept(GLenum mode, GLsizei count, GLenum type, const GLvoid *uindices, const GLuint *range) {
+    block_t *block = block_from_elements(mode, count, type, uindices, range);
+    bl_end(block);
     displaylist_t *list = state.list.active;
     if (list) {
-        GLsizei min, max;
+        dl_append_block(list, block);
+    } else {
+        bl_draw(block);
+        bl_free(block);
+    }
+}
 
-        normalize_indices(indices, &max, &min, count);
-        block_t *block = block_from_arrays(mode, min, max + 1);
-        block->indices = indices;
-        block->len = count;
+static inline void bind_pointer(pointer_state_t *p) {
+    gles_buffer_bind(GL_ARRAY_BUFFER, p->buffer ? p->buffer->buffer : 0);
+}
 
-        bl_end(block);
-        if (list) {
-            dl_append_block(list, block);
-        } else {
-            bl_draw(block);
-            bl_free(block);
+// points the GLES client arrays at vertex `base` (0 restores the app's pointers)
+// so 16-bit indices can address a window anywhere in a large array
+void gles_arrays_rebase(GLuint base) {
+    LOAD_GLES(glClientActiveTexture);
+    LOAD_GLES(glColorPointer);
+    LOAD_GLES(glNormalPointer);
+    LOAD_GLES(glTexCoordPointer);
+    LOAD_GLES(glVertexPointer);
+    // pointers into a buffer are offsets, and need it bound when they're set
+    #define offset(p, width) \
+        (bind_pointer(p), \
+         (const GLubyte *)(p)->pointer + base * ((p)->stride ? (p)->stride : (width) * gl_sizeof((p)->type)))
+
+    pointer_state_t *p = &state.pointers.vertex;
+    if (state.enable.vertex_array) {
+        gles_glVertexPointer(p->size, p->type, p->stride, offset(p, p->size));
+    }
+    p = &state.pointers.color;
+    if (state.enable.color_array) {
+        gles_glColorPointer(p->size, p->type, p->stride, offset(p, p->size));
+    }
+    p = &state.pointers.normal;
+    if (state.enable.normal_array) {
+        gles_glNormalPointer(p->type, p->stride, offset(p, 3));
+    }
+    GLuint client = state.texture.client;
+    for (int i = 0; i < MAX_TEX; i++) {
+        p = &state.pointers.tex_coord[i];
+        if (state.enable.tex_coord_array[i]) {
+            if (client != i) {
+                gles_glClientActiveTexture(GL_TEXTURE0 + i);
+                client = i;
+            }
+            gles_glTexCoordPointer(p->size, p->type, p->stride, offset(p, p->size));
         }
-    } else {
+    }
+    if (client != state.texture.client) {
+        gles_glClientActiveTexture(GL_TEXTURE0 + state.texture.client);
+    }
+    gles_buffers_restore();
+    #undef offset
+}
+
+// copies vertices [first, first + count) of each enabled array into the stream
+// ring and points GLES at them, so the draw starts from vertex 0. Arrays already
+// in a buffer are just offset. gles_arrays_rebase(0) puts the app's pointers
+// back afterwards. false, with nothing changed, if the arrays don't fit.
+static bool gles_arrays_stream(GLint first, GLsizei count) {
+    LOAD_GLES(glClientActiveTexture);
+    LOAD_GLES(glColorPointer);
+    LOAD_GLES(glNormalPointer);
+    LOAD_GLES(glTexCoordPointer);
+    LOAD_GLES(glVertexPointer);
+    #define size(p, width) ((count - 1) * (p)->real_stride + (width) * gl_sizeof((p)->type))
+    #define upload(p, width) \
+        ((p)->buffer ? (bind_pointer(p), (const GLubyte *)(p)->pointer + first * (p)->real_stride) : \
+         stream_pointer((const GLubyte *)(p)->pointer + first * (p)->real_stride, size(p, width)))
+    // reserved as a whole, so a wrap can't orphan the arrays uploaded first
+    #define reserve(enabled, p, width) \
+        if ((enabled) && ! (p)->buffer) total += (size(p, width) + 3) & ~3
+
+    GLsizeiptr total = 0;
+    reserve(state.enable.vertex_array, &state.pointers.vertex, state.pointers.vertex.size);
+    reserve(state.enable.color_array, &state.pointers.color, state.pointers.color.size);
+    reserve(state.enable.normal_array, &state.pointers.normal, 3);
+    for (int i = 0; i < MAX_TEX; i++) {
+        reserve(state.enable.tex_coord_array[i], &state.pointers.tex_coord[i],
+                state.pointers.tex_coord[i].size);
+    }
+    if (! stream_reserve(total)) {
+        return false;
+    }
+
+    pointer_state_t *p = &state.pointers.vertex;
+    if (state.enable.vertex_array) {
+        gles_glVertexPointer(p->size, p->type, p->real_stride, upload(p, p->size));
+    }
+    p = &state.pointers.color;
+    if (state.enable.color_array) {
+        gles_glColorPointer(p->size, p->type, p->real_stride, upload(p, p->size));
+    }
+    p = &state.pointers.normal;
+    if (state.enable.normal_array) {
+        gles_glNormalPointer(p->type, p->real_stride, upload(p, 3));
+    }
+    GLuint client = state.texture.client;
+    for (int i = 0; i < MAX_TEX; i++) {
+        p = &state.pointers.tex_coord[i];
+        if (state.enable.tex_coord_array[i]) {
+            if (client != i) {
+                gles_glClientActiveTexture(GL_TEXTURE0 + i);
+                client = i;
+            }
+            gles_glTexCoordPointer(p->size, p->type, p->real_stride, upload(p, p->size));
+        }
+    }
+    if (client != state.texture.client) {
+        gles_glClientActiveTexture(GL_TEXTURE0 + state.texture.client);
+    }
+    gles_buffers_restore();
+    #undef reserve
+    #undef upload
+    #undef size
+    return true;
+}
+
+// draws GL_QUADS from the app's own arrays using the cached q2t winding
+static bool draw_quads_direct(GLint first, GLsizei count) {
+    // a trailing partial quad is ignored, same as GL does
+    count -= count % 4;
+    if (first + count > 65536 || ! gles_arrays_valid()) {
+        return false;
+    }
+    if (count > 0) {
         LOAD_GLES(glDrawElements);
-        gles_glDrawElements(mode, count, type, indices);
-        free(indices);
+        gl_matrix_flush();
+        gl_texture_flush();
+        // the q2t indices are ours, not in the app's element buffer
+        gles_buffer_bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+        if (stream_enabled() && gles_arrays_stream(first, count)) {
+            gles_glDrawElements(GL_TRIANGLES, count * 1.5, GL_UNSIGNED_SHORT, bl_q2t_indices(0, count));
+            gles_arrays_rebase(0);
+        } else {
+            GLushort *indices = bl_q2t_indices(first, count);
+            gles_glDrawElements(GL_TRIANGLES, count * 1.5, GL_UNSIGNED_SHORT, indices);
+        }
+        gles_buffers_restore();
+    }
+    return true;
+}
+
+// draws 32-bit indices on a driver without OES_element_index_uint by splitting
+// them into runs of whole primitives whose vertices fit in a 16-bit window
+static bool draw_elements_ranged(GLenum mode, GLsizei count, const GLuint *indices, GLuint min, GLuint max) {
+    LOAD_GLES(glDrawElements);
+    if (max - min <= 65535) {
+        // only move the arrays if the indices don't already fit
+        GLuint base = (max <= 65535) ? 0 : min;
+        GLushort *tmp = gl_rebase_indices(indices, GL_UNSIGNED_INT, count, base);
+        if (base) gles_arrays_rebase(base);
+        gles_buffer_bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gles_glDrawElements(mode, count, GL_UNSIGNED_SHORT, tmp);
+        gles_buffers_restore();
+        if (base) gles_arrays_rebase(0);
+        free(tmp);
+        return true;
+    }
+
+    // connected primitives can't be cut without changing what's drawn
+    GLsizei per;
+    switch (mode) {
+        case GL_POINTS: per = 1; break;
+        case GL_LINES: per = 2; break;
+        case GL_TRIANGLES: per = 3; break;
+        default:
+            return false;
+    }
+    count -= count % per;
+    GLushort *tmp = malloc(count * sizeof(GLushort));
+    GLsizei start = 0;
+    GLuint base = 0;
+    while (start < count) {
+        GLuint lo = indices[start], hi = lo;
+        GLsizei end = start;
+        while (end < count) {
+            GLuint plo = lo, phi = hi;
+            for (int i = end; i < end + per; i++) {
+                plo = MIN(plo, indices[i]);
+                phi = MAX(phi, indices[i]);
+            }
+            if (phi - plo > 65535) {
+                break;
+            }
+            lo = plo;
+            hi = phi;
+            end += per;
+        }
+        if (end == start) {
+            // a single primitive spanning more than 16 bits goes through a block
+            draw_elements_intercept(mode, per, GL_UNSIGNED_INT, &indices[start], NULL);
+            start += per;
+            // bl_draw puts the app's pointers back when it's done
+            base = 0;
+            continue;
+        }
+        // keep the current window if the run still fits in it
+        if (lo < base || hi - base > 65535) {
+            base = (hi <= 65535) ? 0 : lo;
+            gles_arrays_rebase(base);
+        }
+        for (int i = start; i < end; i++) {
+            tmp[i - start] = indices[i] - base;
+        }
+        gles_buffer_bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gles_glDrawElements(mode, end - start, GL_UNSIGNED_SHORT, tmp);
+        start = end;
+    }
+    gles_buffers_restore();
+    if (base) {
+        gles_arrays_rebase(0);
+    }
+    free(tmp);
+    return true;
+}
+
+// the list primitive that sub-draws of `mode` are merged into
+static GLenum merged_mode(GLenum mode) {
+    switch (mode) {
+        case GL_POINTS:
+            return GL_POINTS;
+        case GL_LINES:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            return GL_LINES;
+        case GL_TRIANGLE_STRIP:
+        case GL_QUAD_STRIP:
+            return GL_TRIANGLE_STRIP;
+        default:
+            return GL_TRIANGLES;
+    }
+}
+
+// appends the primitives that the `count` vertices in `v` make in `mode` to
+// out[len], as merged_mode(mode), and returns the new length.
+// out needs room for count * 3 + 4 more indices.
+static GLsizei merge_primitives(GLenum mode, const GLuint *v, GLsizei count, GLuint *out, GLsizei len) {
+    switch (mode) {
+        case GL_POINTS:
+            break;
+        case GL_LINES:
+            count -= count % 2;
+            break;
+        case GL_TRIANGLES:
+            count -= count % 3;
+            break;
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            for (int i = 1; i < count; i++) {
+                out[len++] = v[i - 1];
+                out[len++] = v[i];
+            }
+            if (mode == GL_LINE_LOOP && count > 1) {
+                out[len++] = v[count - 1];
+                out[len++] = v[0];
+            }
+            return len;
+        case GL_TRIANGLE_FAN:
+        case GL_POLYGON:
+            for (int i = 2; i < count; i++) {
+                out[len++] = v[0];
+                out[len++] = v[i - 1];
+                out[len++] = v[i];
+            }
+            return len;
+        case GL_QUADS:
+            // same winding as bl_q2t
+            for (int i = 0; i + 3 < count; i += 4) {
+                out[len++] = v[i + 0];
+                out[len++] = v[i + 1];
+                out[len++] = v[i + 3];
+                out[len++] = v[i + 1];
+                out[len++] = v[i + 2];
+                out[len++] = v[i + 3];
+            }
+            return len;
+        case GL_QUAD_STRIP:
+            count -= count % 2;
+        case GL_TRIANGLE_STRIP:
+            if (count < 3) {
+                return len;
+            }
+            // join to the previous strip with degenerate triangles, starting
+            // this one at an even position so its winding is kept
+            if (len > 0) {
+                GLuint last = out[len - 1];
+                if (len % 2) {
+                    out[len++] = last;
+                }
+                out[len++] = last;
+                out[len++] = v[0];
+            }
+            break;
+        default:
+            return len;
+    }
+    memcpy(out + len, v, count * sizeof(GLuint));
+    return len + count;
+}
+
+// draws merged client-side indices from the app's arrays
+static void draw_merged(GLenum mode, GLsizei count, GLuint *indices) {
+    if (! count) {
+        return;
+    }
+    LOAD_GLES(glDrawElements);
+    gl_matrix_flush();
+    gl_texture_flush();
+    GLuint min, max;
+    gl_index_range(indices, GL_UNSIGNED_INT, count, &min, &max);
+    if (max <= 65535) {
+        GLushort *tmp = gl_rebase_indices(indices, GL_UNSIGNED_INT, count, 0);
+        gles_buffer_bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gles_glDrawElements(mode, count, GL_UNSIGNED_SHORT, tmp);
+        gles_buffers_restore();
+        free(tmp);
+    } else if (gl_driver_extension("GL_OES_element_index_uint")) {
+        gles_buffer_bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+        gles_glDrawElements(mode, count, GL_UNSIGNED_INT, indices);
+        gles_buffers_restore();
+    } else if (! draw_elements_ranged(mode, count, indices, min, max)) {
+        GLuint range[] = {min, max};
+        draw_elements_intercept(mode, count, GL_UNSIGNED_INT, indices, range);
+    }
+}
+
+// draws the `count` vertices in `v` straight from the app's arrays, for when
+// one of them is in a buffer without a shadow the CPU could read it from.
+// whatever the intercept would have added (texgen, select, ...) is skipped.
+static void draw_unreadable(GLenum mode, GLsizei count, const GLuint *v) {
+    if (state.render.mode != GL_RENDER) {
+        // select and feedback draw nothing, and have nothing to report without the data
+        return;
+    }
+    GLuint *merged = malloc((count * 3 + 4) * sizeof(GLuint));
+    draw_merged(merged_mode(mode), merge_primitives(mode, v, count, merged, 0), merged);
+    free(merged);
+}
+
+static inline bool valid_index_type(GLenum type) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_SHORT:
+        case GL_UNSIGNED_INT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// glDrawElements, with the [min, max] index range in `range` if the app gave one
+static void draw_elements(GLenum mode, GLsizei count, GLenum type, const GLvoid *uindices, const GLuint *range) {
+    if (mode == GL_QUAD_STRIP)
+        mode = GL_TRIANGLE_STRIP;
+    else if (mode == GL_POLYGON)
+        mode = GL_TRIANGLE_FAN;
+
+    // with an element buffer bound uindices is an offset into it
+    const GLvoid *indices = gl_element_data(uindices);
+    if (should_intercept_render(mode) || state.list.active) {
+        if (! indices) {
+            return;
+        }
+        if (state.list.active || gl_arrays_readable()) {
+            draw_elements_intercept(mode, count, type, indices, range);
+        } else {
+            GLuint *v = gl_copy_array(indices, type, 1, 0, GL_UNSIGNED_INT, 1, 0, count, false);
+            draw_unreadable(mode, count, v);
+            free(v);
+        }
+        return;
+    }
+
+    LOAD_GLES(glDrawElements);
+    gl_matrix_flush();
+    gl_texture_flush();
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_SHORT:
+            // GLES takes these as-is
+            gles_glDrawElements(mode, count, type, uindices);
+            break;
+        case GL_UNSIGNED_INT: {
+            if (gl_driver_extension("GL_OES_element_index_uint")) {
+                gles_glDrawElements(mode, count, type, uindices);
+                break;
+            }
+            if (! indices) {
+                break;
+            }
+            GLuint min, max;
+            if (range) {
+                min = range[0];
+                max = range[1];
+            } else {
+                gl_index_range(indices, type, count, &min, &max);
+            }
+            if (! draw_elements_ranged(mode, count, indices, min, max)) {
+                draw_elements_intercept(mode, count, type, indices, range);
+            }
+            break;
+        }
+    }
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *uindices) {
+    if (count < 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    if (! valid_index_type(type)) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    draw_elements(mode, count, type, uindices, NULL);
+}
+
+// start/end spare us scanning the indices for their range
+void glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const GLvoid *indices) {
+    if (count < 0 || end < start) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    if (! valid_index_type(type)) {
+        ERROR(GL_INVALID_ENUM);
     }
+    GLuint range[] = {start, end};
+    draw_elements(mode, count, type, indices, range);
 }
 
 void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
@@ -217,41 +840,160 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
         return;
     }
 
-    if (should_intercept_render(mode)) {
-        block_t *block = block_from_arrays(mode, first, count);
+    if (mode == GL_QUADS && ! should_intercept_state(mode)) {
+        if (draw_quads_direct(first, count)) {
+            return;
+        }
+    }
+
+    if (should_intercept_render(mode) && count > 0 && ! gl_arrays_readable()) {
+        GLuint *v = malloc(count * sizeof(GLuint));
+        for (int i = 0; i < count; i++) {
+            v[i] = first + i;
+        }
+        draw_unreadable(mode, count, v);
+        free(v);
+    } else if (should_intercept_render(mode)) {
+        block_t *block = block_from_locked(mode, first, count);
+        if (! block) {
+            block = block_from_arrays(mode, first, count);
+        }
         bl_end(block);
         bl_draw(block);
         bl_free(block);
     } else {
         LOAD_GLES(glDrawArrays);
-        gles_glDrawArrays(mode, first, count);
+        gl_matrix_flush();
+        gl_texture_flush();
+        if (stream_enabled() && count > 0 && gles_arrays_stream(first, count)) {
+            gles_glDrawArrays(mode, 0, count);
+            gles_arrays_rebase(0);
+        } else {
+            gles_glDrawArrays(mode, first, count);
+        }
+    }
+}
+
+// whether sub-draws of `mode` can go to GLES as one merged draw
+static bool can_merge(GLenum mode) {
+    if (state.list.active) {
+        return false;
+    }
+    if (mode == GL_QUADS) {
+        return ! should_intercept_state(mode) && gles_arrays_valid();
+    }
+    return ! should_intercept_render(mode);
+}
+
+void glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount) {
+    if (drawcount < 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    if (! gl_valid_mode(mode)) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    GLsizei total = 0, largest = 0;
+    for (int i = 0; i < drawcount; i++) {
+        if (count[i] < 0) {
+            ERROR(GL_INVALID_VALUE);
+        }
+        total += count[i];
+        largest = MAX(largest, count[i]);
+    }
+    if (! can_merge(mode)) {
+        for (int i = 0; i < drawcount; i++) {
+            if (count[i] > 0) {
+                glDrawArrays(mode, first[i], count[i]);
+            }
+        }
+        return;
     }
+    GLuint *merged = malloc((total * 3 + drawcount * 4) * sizeof(GLuint));
+    GLuint *v = malloc(largest * sizeof(GLuint));
+    GLsizei len = 0;
+    for (int i = 0; i < drawcount; i++) {
+        for (int j = 0; j < count[i]; j++) {
+            v[j] = first[i] + j;
+        }
+        len = merge_primitives(mode, v, count[i], merged, len);
+    }
+    draw_merged(merged_mode(mode), len, merged);
+    free(v);
+    free(merged);
+}
+
+void glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type, GLvoid *const *indices, GLsizei drawcount) {
+    if (drawcount < 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    if (! gl_valid_mode(mode)) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    if (! valid_index_type(type)) {
+        ERROR(GL_INVALID_ENUM);
+    }
+    GLsizei total = 0;
+    for (int i = 0; i < drawcount; i++) {
+        if (count[i] < 0) {
+            ERROR(GL_INVALID_VALUE);
+        }
+        total += count[i];
+    }
+    if (! can_merge(mode)) {
+        for (int i = 0; i < drawcount; i++) {
+            if (count[i] > 0) {
+                glDrawElements(mode, count[i], type, indices[i]);
+            }
+        }
+        return;
+    }
+    GLuint *merged = malloc((total * 3 + drawcount * 4) * sizeof(GLuint));
+    GLsizei len = 0;
+    for (int i = 0; i < drawcount; i++) {
+        const GLvoid *data = gl_element_data(indices[i]);
+        if (! data || count[i] <= 0) {
+            continue;
+        }
+        GLuint *v = (GLuint *)data;
+        if (type != GL_UNSIGNED_INT) {
+            v = gl_copy_array(data, type, 1, 0, GL_UNSIGNED_INT, 1, 0, count[i], false);
+        }
+        len = merge_primitives(mode, v, count[i], merged, len);
+        if (v != data) {
+            free(v);
+        }
+    }
+    draw_merged(merged_mode(mode), len, merged);
+    free(merged);
 }
 
 #ifndef USE_ES2
-#define clone_gl_pointer(t, s)\
-    t.size = s; t.type = type; t.stride = stride; t.pointer = pointer;
+#define clone_gl_pointer(t, s, normalize)\
+    t.size = s; t.type = type; t.stride = stride; t.pointer = pointer;\
+    t.buffer = state.buffers.array;\
+    t.real_stride = stride ? stride : s * gl_sizeof(type);\
+    t.fetch = gl_pointer_fetch(type, s, normalize);
 void glVertexPointer(GLint size, GLenum type,
                      GLsizei stride, const GLvoid *pointer) {
     LOAD_GLES(glVertexPointer);
-    clone_gl_pointer(state.pointers.vertex, size);
+    clone_gl_pointer(state.pointers.vertex, size, false);
     gles_glVertexPointer(size, type, stride, pointer);
 }
 void glColorPointer(GLint size, GLenum type,
                      GLsizei stride, const GLvoid *pointer) {
     LOAD_GLES(glColorPointer);
-    clone_gl_pointer(state.pointers.color, size);
+    clone_gl_pointer(state.pointers.color, size, true);
     gles_glColorPointer(size, type, stride, pointer);
 }
 void glNormalPointer(GLenum type, GLsizei stride, const GLvoid *pointer) {
     LOAD_GLES(glNormalPointer);
-    clone_gl_pointer(state.pointers.normal, 3);
+    clone_gl_pointer(state.pointers.normal, 3, false);
     gles_glNormalPointer(type, stride, pointer);
 }
 void glTexCoordPointer(GLint size, GLenum type,
                      GLsizei stride, const GLvoid *pointer) {
     LOAD_GLES(glTexCoordPointer);
-    clone_gl_pointer(state.pointers.tex_coord[state.texture.client], size);
+    clone_gl_pointer(state.pointers.tex_coord[state.texture.client], size, false);
     gles_glTexCoordPointer(size, type, stride, pointer);
 }
 #undef clone_gl_pointer
@@ -281,7 +1023,7 @@ void glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer) {
             break;
         case GL_C3F_V3F:
             color = 3;
-            vert = 4;
+            vert = 3;
             break;
         case GL_N3F_V3F:
             normal = 3;
@@ -335,6 +1077,16 @@ void glInterleavedArrays(GLenum format, GLsizei stride, const GLvoid *pointer) {
                  color * gl_sizeof(cf) +
                  normal * gl_sizeof(nf) +
                  vert * gl_sizeof(vf);
+    // the format decides which arrays are enabled, too
+    #define enable_array(cap, enable) \
+        if (enable) glEnableClientState(cap); else glDisableClientState(cap)
+    enable_array(GL_TEXTURE_COORD_ARRAY, tex);
+    enable_array(GL_COLOR_ARRAY, color);
+    enable_array(GL_NORMAL_ARRAY, normal);
+    enable_array(GL_VERTEX_ARRAY, vert);
+    #undef enable_array
+
+    // intercepted draws recognize the shared stride and convert in one pass
     if (tex) {
         glTexCoordPointer(tex, tf, stride, (GLvoid *)ptr);
         ptr += tex * gl_sizeof(tf);
@@ -449,53 +1201,87 @@ void glArrayElement(GLint i) {
     if (i < 0) {
         ERROR(GL_INVALID_VALUE);
     }
-    GLfloat *v;
+    block_t *block = state.block.active;
+    GLfloat v[4];
     pointer_state_t *p;
-    p = &state.pointers.color;
-    if (state.enable.color_array && p->pointer) {
-        v = gl_pointer_index(p, i);
-        GLuint scale = gl_max_value(p->type);
-        // color[3] defaults to 1.0f
-        if (p->size < 4)
-            v[3] = 1.0f;
+    #define enabled(array, p) (state.enable.array && (p)->fetch && gl_pointer_data(p))
+    #define fetch(p, out) (p)->fetch((const GLubyte *)gl_pointer_data(p) + i * (p)->real_stride, out)
 
-        // scale color coordinates to a 0 - 1.0 range
-        for (int i = 0; i < p->size; i++) {
-            v[i] /= scale;
+    p = &state.pointers.color;
+    if (enabled(color_array, p)) {
+        if (block) {
+            bl_track_color(block);
+            fetch(p, CURRENT->color);
+        } else {
+            fetch(p, v);
+            glColor4fv(v);
         }
-        glColor4fv(v);
     }
     p = &state.pointers.normal;
-    if (state.enable.normal_array && p->pointer) {
-        v = gl_pointer_index(p, i);
-        glNormal3fv(v);
+    if (enabled(normal_array, p)) {
+        fetch(p, v);
+        if (block) {
+            bl_track_normal(block);
+            memcpy(CURRENT->normal, v, 3 * sizeof(GLfloat));
+        } else {
+            glNormal3fv(v);
+        }
     }
-    for (int i = 0; i < MAX_TEX; i++) {
-        p = &state.pointers.tex_coord[i];
-        if (state.enable.tex_coord_array[i] && p->pointer) {
-            v = gl_pointer_index(p, i);
-            glMultiTexCoord2fv(GL_TEXTURE0 + i, v);
+    for (int t = 0; t < MAX_TEX; t++) {
+        p = &state.pointers.tex_coord[t];
+        if (enabled(tex_coord_array[t], p)) {
+            fetch(p, v);
+            if (block) {
+                bl_track_tex(block, GL_TEXTURE0 + t);
+                memcpy(CURRENT->tex[t], v, 2 * sizeof(GLfloat));
+            } else {
+                glMultiTexCoord2fv(GL_TEXTURE0 + t, v);
+            }
         }
     }
+    // vertices outside glBegin/glEnd are dropped like glVertex3f does
     p = &state.pointers.vertex;
-    if (state.enable.vertex_array && p->pointer) {
-        v = gl_pointer_index(p, i);
+    if (block && enabled(vertex_array, p)) {
+        fetch(p, v);
         if (p->size == 4) {
-            glVertex4fv(v);
+            bl_vertex3f(block, v[0] / v[3], v[1] / v[3], v[2] / v[3]);
         } else {
-            glVertex3fv(v);
+            bl_vertex3f(block, v[0], v[1], v[2]);
         }
     }
+    #undef fetch
+    #undef enabled
 }
 
-// TODO: between a lock and unlock, I can assume the array pointers are unchanged
-// so I can build a block_t on the first call and hold onto it
-// maybe I need a way to call a block_t with (first, count)
+// between a lock and unlock the array contents can be assumed unchanged, so
+// intercepted draws convert the locked range once and share it
 void glLockArraysEXT(GLint first, GLsizei count) {
+    ERROR_IN_BLOCK();
+    if (first < 0 || count <= 0) {
+        ERROR(GL_INVALID_VALUE);
+    }
+    if (state.block.locked) {
+        ERROR(GL_INVALID_OPERATION);
+    }
     state.block.locked = true;
+    state.block.arrays.first = first;
+    state.block.arrays.count = count;
 }
 
 void glUnlockArraysEXT() {
+    ERROR_IN_BLOCK();
+    if (! state.block.locked) {
+        ERROR(GL_INVALID_OPERATION);
+    }
+    locked_arrays_t *locked = &state.block.arrays;
+    free(locked->vert);
+    free(locked->normal);
+    free(locked->color);
+    for (int i = 0; i < MAX_TEX; i++) {
+        free(locked->tex[i]);
+        free(locked->texgen[i].coords);
+    }
+    memset(locked, 0, sizeof(locked_arrays_t));
     state.block.locked = false;
 }
 
@@ -24,8 +24,8 @@ void glMaterialfv(GLenum face, GLenum pname, const GLfloat *params) {
     gles_glMaterialfv(GL_FRONT_AND_BACK, pname, params);
 }
 
-#ifdef LOCAL_MATRIX
 void glLightfv(GLenum light, GLenum pname, const GLfloat *params) {
+#ifdef LOCAL_MATRIX
     LOAD_GLES(glLightfv);
     ERROR_IN_BLOCK();
     GLfloat tmp[4];
@@ -37,6 +37,17 @@ void glLightfv(GLenum light, GLenum pname, const GLfloat *params) {
             gles_glLightfv(light, pname, params);
             break;
     }
-}
+#else
+    PUSH_IF_COMPILING(glLightfv);
+    ERROR_IN_BLOCK();
+    switch (pname) {
+        // GLES transforms these by the modelview as it is at the call
+        case GL_POSITION:
+        case GL_SPOT_DIRECTION:
+            gl_matrix_flush();
+            break;
+    }
+    PROXY_GLES(glLightfv);
 #endif
+}
 #endif
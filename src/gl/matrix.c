@@ -5,34 +5,48 @@
 #include "vectorial/simd4f.h"
 #include "vectorial/simd4x4f.h"
 
-#ifdef LOCAL_MATRIX
-#define PROXY_MATRIX(name)
-#else
-#define PROXY_MATRIX(name) PROXY_GLES(name)
-#endif
-
 // helper functions
+static simd4x4f *alloc_stack(uint32_t cap) {
+    void *stack;
+    if (posix_memalign(&stack, sizeof(simd4f), cap * sizeof(simd4x4f)) != 0) {
+        return NULL;
+    }
+    return stack;
+}
+
 static matrix_state_t *get_matrix_state(GLenum mode) {
     matrix_state_t *m;
+    uint32_t cap;
     switch (mode) {
         case GL_MODELVIEW:
             m = &state.matrix.model;
+            cap = MODELVIEW_STACK_DEPTH;
             break;
         case GL_PROJECTION:
             m = &state.matrix.projection;
+            cap = PROJECTION_STACK_DEPTH;
             break;
         case GL_TEXTURE:
-            m = &state.matrix.texture[state.texture.client];
+            m = &state.matrix.texture[state.texture.active];
+            cap = TEXTURE_STACK_DEPTH;
             break;
-    /* defined in ARB_imaging extension
+        // defined in ARB_imaging extension
         case GL_COLOR:
             m = &state.matrix.color;
+            cap = 2;
+            break;
+        // glMatrixMode rejects anything else, so this is never reached
+        default:
+            m = &state.matrix.model;
+            cap = MODELVIEW_STACK_DEPTH;
             break;
-    */
     }
 
     if (! m->init) {
         simd4x4f_identity(&m->matrix);
+        m->affine = true;
+        m->stack = alloc_stack(cap);
+        m->cap = m->stack ? cap : 0;
         m->init = true;
     }
     return m;
@@ -45,17 +59,13 @@ static void transpose(GLfloat *out, const GLfloat *m) {
     simd4x4f_ustore(&tmp, out);
 }
 
-static bool mvp_dirty = true;
+static bool mvp_dirty = true, mvp_affine = true;
 static simd4x4f mvp;
 
 static simd4x4f *get_matrix(GLenum mode) {
     return &get_matrix_state(mode)->matrix;
 }
 
-static simd4x4f *get_current_matrix() {
-    return get_matrix(state.matrix.mode);
-}
-
 static matrix_state_t *get_current_state() {
     return get_matrix_state(state.matrix.mode);
 }
@@ -64,31 +74,79 @@ static void update_mvp() {
     simd4x4f *model = get_matrix(GL_MODELVIEW);
     simd4x4f *projection = get_matrix(GL_PROJECTION);
     simd4x4f_matrix_mul(projection, model, &mvp);
+    mvp_affine = state.matrix.model.affine && state.matrix.projection.affine;
     mvp_dirty = false;
 }
 
-static void upload_matrix() {
+// matrices are only uploaded by gl_matrix_flush, so a run of transforms
+// costs a single glLoadMatrixf
+static void matrix_changed(matrix_state_t *m) {
+    m->version++;
+    mvp_dirty = true;
+    m->dirty = true;
+    state.matrix.dirty = true;
+}
+
+static void gles_matrix_mode(GLenum mode) {
+    if (state.matrix.gles_mode != mode) {
+        LOAD_GLES(glMatrixMode);
+        gles_glMatrixMode(mode);
+        state.matrix.gles_mode = mode;
+    }
+}
+
+static void upload_matrix(GLenum mode, matrix_state_t *m) {
     LOAD_GLES(glLoadMatrixf);
-    GLfloat tmp[16];
-    simd4x4f_ustore(get_current_matrix(), tmp);
-    gles_glLoadMatrixf(tmp);
+    gles_matrix_mode(mode);
+    // simd4x4f is four packed columns, already the layout GLES wants
+    gles_glLoadMatrixf((const GLfloat *)&m->matrix);
+    m->dirty = false;
+}
+
+// uploads the matrices changed since the last call. anything GLES does with
+// the matrices (draws, light positions, clip planes) needs this first
+void gl_matrix_flush() {
+#ifndef LOCAL_MATRIX
+    if (! state.matrix.dirty) {
+        return;
+    }
+    state.matrix.dirty = false;
+    if (state.matrix.projection.dirty) {
+        upload_matrix(GL_PROJECTION, &state.matrix.projection);
+    }
+    for (int i = 0; i < MAX_TEX; i++) {
+        if (state.matrix.texture[i].dirty) {
+            LOAD_GLES(glActiveTexture);
+            GLuint active = state.texture.active;
+            if (i != active) gles_glActiveTexture(GL_TEXTURE0 + i);
+            upload_matrix(GL_TEXTURE, &state.matrix.texture[i]);
+            if (i != active) gles_glActiveTexture(GL_TEXTURE0 + active);
+        }
+    }
+    // last, so GLES is usually left in modelview
+    if (state.matrix.model.dirty) {
+        upload_matrix(GL_MODELVIEW, &state.matrix.model);
+    }
+#endif
 }
 
 // GL matrix functions
 void glLoadIdentity() {
     PUSH_IF_COMPILING(glLoadIdentity);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
-    simd4x4f_identity(get_current_matrix());
-    PROXY_MATRIX(glLoadIdentity);
+    matrix_state_t *m = get_current_state();
+    simd4x4f_identity(&m->matrix);
+    m->affine = true;
+    matrix_changed(m);
 }
 
 void glLoadMatrixf(const GLfloat *m) {
     PUSH_IF_COMPILING(glLoadMatrixf);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
-    simd4x4f_uload(get_current_matrix(), m);
-    PROXY_MATRIX(glLoadMatrixf);
+    matrix_state_t *cur = get_current_state();
+    simd4x4f_uload(&cur->matrix, m);
+    cur->affine = simd4x4f_is_affine(&cur->matrix);
+    matrix_changed(cur);
 }
 
 void glLoadTransposeMatrixf(const GLfloat *m) {
@@ -111,19 +169,20 @@ void glMatrixMode(GLenum mode) {
         default:
             ERROR(GL_INVALID_ENUM);
     }
+    // GLES follows along when a matrix is uploaded
     state.matrix.mode = mode;
-    PROXY_MATRIX(glMatrixMode);
 }
 
 void glMultMatrixf(const GLfloat *m) {
     PUSH_IF_COMPILING(glMultMatrixf);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
-    simd4x4f out, load, *cur = get_current_matrix();
+    matrix_state_t *cur = get_current_state();
+    simd4x4f out, load;
     simd4x4f_uload(&load, m);
-    simd4x4f_matrix_mul(cur, &load, &out);
-    *cur = out;
-    upload_matrix();
+    simd4x4f_matrix_mul(&cur->matrix, &load, &out);
+    cur->matrix = out;
+    cur->affine = cur->affine && simd4x4f_is_affine(&load);
+    matrix_changed(cur);
 }
 
 void glMultTransposeMatrixf(const GLfloat *m) {
@@ -137,59 +196,65 @@ void glMultTransposeMatrixf(const GLfloat *m) {
 void glPopMatrix() {
     PUSH_IF_COMPILING(glPopMatrix);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
     matrix_state_t *m = get_current_state();
-    simd4x4f *top = tack_pop(&m->stack);
-    if (top == NULL) {
+    if (m->depth == 0) {
        ERROR(GL_STACK_UNDERFLOW);
     }
-    m->matrix = *top;
-    free(top);
-    upload_matrix();
+    m->matrix = m->stack[--m->depth];
+    m->affine = simd4x4f_is_affine(&m->matrix);
+    matrix_changed(m);
 }
 
 void glPushMatrix() {
     PUSH_IF_COMPILING(glPushMatrix);
     ERROR_IN_BLOCK();
     matrix_state_t *m = get_current_state();
-    simd4x4f *push = malloc(sizeof(simd4x4f));
-    *push = m->matrix;
-    tack_push(&m->stack, push);
+    // GL counts the current matrix as part of the stack
+    if (m->depth + 1 >= MAX_MATRIX_STACK_DEPTH) {
+        ERROR(GL_STACK_OVERFLOW);
+    }
+    if (m->depth == m->cap) {
+        // cap is 0 if the initial stack couldn't be allocated
+        uint32_t cap = m->cap ? m->cap * 2 : 1;
+        if (cap > MAX_MATRIX_STACK_DEPTH) {
+            cap = MAX_MATRIX_STACK_DEPTH;
+        }
+        simd4x4f *stack = alloc_stack(cap);
+        if (! stack) {
+            ERROR(GL_OUT_OF_MEMORY);
+        }
+        memcpy(stack, m->stack, m->depth * sizeof(simd4x4f));
+        free(m->stack);
+        m->stack = stack;
+        m->cap = cap;
+    }
+    m->stack[m->depth++] = m->matrix;
 }
 
 // GL transform functions
 void glRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
     PUSH_IF_COMPILING(glRotatef);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
     float radians = angle * VECTORIAL_PI / 180;
-    simd4x4f *m = get_current_matrix(), rotate, out;
-    simd4x4f_axis_rotation(&rotate, radians, simd4f_create(x, y, z, 1.0f));
-    simd4x4f_matrix_mul(m, &rotate, &out);
-    *m = out;
-    upload_matrix();
+    matrix_state_t *m = get_current_state();
+    simd4x4f_rotate_inplace(&m->matrix, radians, simd4f_create(x, y, z, 1.0f));
+    matrix_changed(m);
 }
 
 void glScalef(GLfloat x, GLfloat y, GLfloat z) {
     PUSH_IF_COMPILING(glScalef);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
-    simd4x4f *m = get_current_matrix(), scale, out;
-    simd4x4f_scaling(&scale, x, y, z);
-    simd4x4f_matrix_mul(m, &scale, &out);
-    *m = out;
-    upload_matrix();
+    matrix_state_t *m = get_current_state();
+    simd4x4f_scale_inplace(&m->matrix, x, y, z);
+    matrix_changed(m);
 }
 
 void glTranslatef(GLfloat x, GLfloat y, GLfloat z) {
     PUSH_IF_COMPILING(glTranslatef);
     ERROR_IN_BLOCK();
-    mvp_dirty = true;
-    simd4x4f *m = get_current_matrix(), translate, out;
-    simd4x4f_translation(&translate, x, y, z);
-    simd4x4f_matrix_mul(m, &translate, &out);
-    *m = out;
-    upload_matrix();
+    matrix_state_t *m = get_current_state();
+    simd4x4f_translate_inplace(&m->matrix, x, y, z);
+    matrix_changed(m);
 }
 
 void glOrthof(GLfloat left, GLfloat right,
@@ -200,12 +265,12 @@ void glOrthof(GLfloat left, GLfloat right,
     if (left == right || bottom == top || near == far) {
         ERROR(GL_INVALID_VALUE);
     }
-    mvp_dirty = true;
-    simd4x4f *m = get_current_matrix(), ortho, out;
+    matrix_state_t *m = get_current_state();
+    simd4x4f ortho, out;
     simd4x4f_ortho(&ortho, left, right, bottom, top, near, far);
-    simd4x4f_matrix_mul(m, &ortho, &out);
-    *m = out;
-    upload_matrix();
+    simd4x4f_matrix_mul(&m->matrix, &ortho, &out);
+    m->matrix = out;
+    matrix_changed(m);
 }
 
 void glFrustumf(GLfloat left, GLfloat right,
@@ -216,12 +281,21 @@ void glFrustumf(GLfloat left, GLfloat right,
     if (near < 0 || far < 0 || left == right || bottom == top || near == far) {
         ERROR(GL_INVALID_VALUE);
     }
-    mvp_dirty = true;
-    simd4x4f *m = get_current_matrix(), frustum, out;
+    matrix_state_t *m = get_current_state();
+    simd4x4f frustum, out;
     simd4x4f_frustum(&frustum, left, right, bottom, top, near, far);
-    simd4x4f_matrix_mul(m, &frustum, &out);
-    *m = out;
-    upload_matrix();
+    simd4x4f_matrix_mul(&m->matrix, &frustum, &out);
+    m->matrix = out;
+    m->affine = false;
+    matrix_changed(m);
+}
+
+// GLES transforms the plane by the modelview as it is at the call
+void glClipPlanef(GLenum plane, const GLfloat *equation) {
+    PUSH_IF_COMPILING(glClipPlanef);
+    ERROR_IN_BLOCK();
+    gl_matrix_flush();
+    PROXY_GLES(glClipPlanef);
 }
 
 void gl_get_matrix(GLenum mode, GLfloat *out) {
@@ -249,12 +323,41 @@ void gl_transform_texture(GLenum texture, GLfloat out[2], const GLfloat in[2]) {
     }
 }
 
-void gl_transform_vertex(GLfloat out[3], GLfloat in[3]) {
+// transforms count packed xyz vertices by the modelview-projection matrix
+// four at a time, one vector per component. out may be in
+void gl_transform_vertices(GLfloat *out, const GLfloat *in, GLsizei count) {
     if (mvp_dirty) {
         update_mvp();
     }
-    simd4f tmp, vert = simd4f_create(in[0], in[1], in[2], 1);
-    simd4x4f_matrix_vector_mul(&mvp, &vert, &tmp);
-    tmp = simd4f_div(tmp, simd4f_splat_w(tmp));
-    simd4f_ustore3(tmp, out);
+    #define row(c) { simd4f_splat_##c(mvp.x), simd4f_splat_##c(mvp.y), \
+                     simd4f_splat_##c(mvp.z), simd4f_splat_##c(mvp.w) }
+    const simd4f mx[4] = row(x), my[4] = row(y), mz[4] = row(z), mw[4] = row(w);
+    #undef row
+    #define dot(m) simd4f_add(simd4f_add(simd4f_mul(x, m[0]), simd4f_mul(y, m[1])), \
+                              simd4f_add(simd4f_mul(z, m[2]), m[3]))
+    GLfloat tail[12];
+    for (int i = 0; i < count; i += 4) {
+        const GLfloat *src = in + i * 3;
+        GLfloat *dst = out + i * 3;
+        int left = count - i;
+        if (left < 4) {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, src, left * 3 * sizeof(GLfloat));
+            src = dst = tail;
+        }
+        simd4f x, y, z;
+        simd4f_uload3x4(src, &x, &y, &z);
+        simd4f tx = dot(mx), ty = dot(my), tz = dot(mz);
+        if (! mvp_affine) {
+            simd4f tw = dot(mw);
+            tx = simd4f_div(tx, tw);
+            ty = simd4f_div(ty, tw);
+            tz = simd4f_div(tz, tw);
+        }
+        simd4f_ustore3x4(tx, ty, tz, dst);
+        if (left < 4) {
+            memcpy(out + i * 3, tail, left * 3 * sizeof(GLfloat));
+        }
+    }
+    #undef dot
 }
@@ -9,9 +9,11 @@ void glMatrixMode(GLenum mode);
 void glMultMatrixf(const GLfloat *m);
 void glPopMatrix();
 void glPushMatrix();
+void glClipPlanef(GLenum plane, const GLfloat *equation);
 void gl_get_matrix(GLenum mode, GLfloat *out);
+void gl_matrix_flush();
 void gl_transform_light(GLfloat out[3], const GLfloat in[3]);
 void gl_transform_texture(GLenum texture, GLfloat out[2], const GLfloat in[2]);
-void gl_transform_vertex(GLfloat out[3], GLfloat in[3]);
+void gl_transform_vertices(GLfloat *out, const GLfloat *in, GLsizei count);
 
 #endif
@@ -1,7 +1,16 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "pixel.h"
 #include "gl_helpers.h"
 #include "gl_str.h"
@@ -15,6 +24,7 @@ static const colorlayout_t *get_color_map(GLenum format) {
         map(GL_ALPHA, -1, -1, -1, 0);
         map(GL_BGR, 2, 1, 0, -1);
         map(GL_BGRA, 2, 1, 0, 3);
+        map(GL_INTENSITY, 0, 0, 0, 0);
         map(GL_LUMINANCE, 0, 0, 0, -1);
         map(GL_LUMINANCE_ALPHA, 0, 0, 0, 1);
         map(GL_RED, 0, -1, -1, -1);
@@ -56,11 +66,12 @@ bool remap_pixel(const GLvoid *src, GLvoid *dst,
         pixel.b = default(s, amod, vmod, src_color->blue, 0);     \
         pixel.a = default(s, amod, vmod, src_color->alpha, 1.0f);
 
+    // red goes last, so luminance is taken from it
     #define write_each(amod, vmod)                         \
-        carefully(d, amod, dst_color->red, pixel.r vmod)   \
-        carefully(d, amod, dst_color->green, pixel.g vmod) \
+        carefully(d, amod, dst_color->alpha, pixel.a vmod) \
         carefully(d, amod, dst_color->blue, pixel.b vmod)  \
-        carefully(d, amod, dst_color->alpha, pixel.a vmod)
+        carefully(d, amod, dst_color->green, pixel.g vmod) \
+        carefully(d, amod, dst_color->red, pixel.r vmod)
 
     // this pixel stores our intermediate color
     // it will be RGBA and normalized to between (0.0 - 1.0f)
@@ -74,9 +85,9 @@ bool remap_pixel(const GLvoid *src, GLvoid *dst,
         type_case(GL_UNSIGNED_SHORT_1_5_5_5_REV, GLushort,
             s = (GLushort[]){
                 v & 31,
-                (v & 0x03e0 >> 5),
-                (v & 0x7c00 >> 10),
-                (v & 0x8000 >> 15)* 31,
+                (v >> 5) & 31,
+                (v >> 10) & 31,
+                (v >> 15) * 31,
             };
             read_each(, / 31.0f);
         )
@@ -96,8 +107,8 @@ bool remap_pixel(const GLvoid *src, GLvoid *dst,
             color[dst_color->red] = pixel.r;
             color[dst_color->green] = pixel.g;
             color[dst_color->blue] = pixel.b;
-            *d = ((GLuint)(color[0] * 31) & 0x1f << 11) |
-                 ((GLuint)(color[1] * 63) & 0x3f << 5) |
+            *d = (((GLuint)(color[0] * 31) & 0x1f) << 11) |
+                 (((GLuint)(color[1] * 63) & 0x3f) << 5) |
                  ((GLuint)(color[2] * 31) & 0x1f);
         )
         type_case(GL_UNSIGNED_SHORT_5_5_5_1, GLushort,
@@ -107,10 +118,10 @@ bool remap_pixel(const GLvoid *src, GLvoid *dst,
             color[dst_color->blue] = pixel.b;
             color[dst_color->alpha] = pixel.a;
             // TODO: can I macro this or something? it follows a pretty strict form.
-            *d = ((GLuint)(color[0] * 31) & 0x1f << 0) |
-                 ((GLuint)(color[1] * 31) & 0x1f << 5) |
-                 ((GLuint)(color[2] * 31) & 0x1f << 10)  |
-                 ((GLuint)(color[3] * 1)  & 0x01 << 15);
+            *d = (((GLuint)(color[0] * 31) & 0x1f) << 11) |
+                 (((GLuint)(color[1] * 31) & 0x1f) << 6) |
+                 (((GLuint)(color[2] * 31) & 0x1f) << 1)  |
+                 ((GLuint)(color[3] * 1)  & 0x01);
         )
        type_case(GL_UNSIGNED_SHORT_4_4_4_4, GLushort,
             GLfloat color[4];
@@ -118,9 +129,9 @@ bool remap_pixel(const GLvoid *src, GLvoid *dst,
             color[dst_color->green] = pixel.g;
             color[dst_color->blue] = pixel.b;
             color[dst_color->alpha] = pixel.a;
-            *d = ((GLushort)(color[0] * 15) & 0x0f << 12) |
-                 ((GLushort)(color[1] * 15) & 0x0f << 8) |
-                 ((GLushort)(color[2] * 15) & 0x0f << 4) |
+            *d = (((GLushort)(color[0] * 15) & 0x0f) << 12) |
+                 (((GLushort)(color[1] * 15) & 0x0f) << 8) |
+                 (((GLushort)(color[2] * 15) & 0x0f) << 4) |
                  ((GLushort)(color[3] * 15) & 0x0f);
         )
         default:
@@ -137,46 +148,648 @@ bool remap_pixel(const GLvoid *src, GLvoid *dst,
     #undef write_each
 }
 
+/*
+Fast paths for the common conversions. Each kernel converts `pixels` packed
+pixels; the table below is searched once per image and anything not in it
+goes through remap_pixel(). Byte reorders are described by `order`: output
+byte c of a pixel is input byte order[c]. `row` is the row's place in the
+image, for the kernels that dither.
+*/
+
+typedef void (*pixel_kernel_t)(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row);
+
+// 4 bytes -> 4 bytes, reordered
+static void kernel_shuffle4(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t in = vld4q_u8(src + i * 4), out;
+        out.val[0] = in.val[order[0]];
+        out.val[1] = in.val[order[1]];
+        out.val[2] = in.val[order[2]];
+        out.val[3] = in.val[order[3]];
+        vst4q_u8(dst + i * 4, out);
+    }
+#elif defined(__SSSE3__)
+    GLubyte m[16];
+    for (int j = 0; j < 16; j++) {
+        m[j] = (j & ~3) + order[j & 3];
+    }
+    const __m128i mask = _mm_loadu_si128((const __m128i *)m);
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(__SSE2__)
+    // SSE2 can't shuffle bytes, but the R/B swap is just masks and shifts
+    if (order[0] == 2 && order[1] == 1 && order[2] == 0 && order[3] == 3) {
+        const __m128i ga = _mm_set1_epi32(0xff00ff00), rb = _mm_set1_epi32(0x000000ff);
+        for (; i + 4 <= pixels; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+            __m128i out = _mm_or_si128(_mm_and_si128(v, ga),
+                          _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), rb),
+                                       _mm_slli_epi32(_mm_and_si128(v, rb), 16)));
+            _mm_storeu_si128((__m128i *)(dst + i * 4), out);
+        }
+    }
+#endif
+    for (; i < pixels; i++) {
+        const GLubyte *s = src + i * 4;
+        GLubyte *d = dst + i * 4;
+        d[0] = s[order[0]];
+        d[1] = s[order[1]];
+        d[2] = s[order[2]];
+        d[3] = s[order[3]];
+    }
+}
+
+// 3 bytes -> 3 bytes, reordered
+static void kernel_shuffle3(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t in = vld3q_u8(src + i * 3), out;
+        out.val[0] = in.val[order[0]];
+        out.val[1] = in.val[order[1]];
+        out.val[2] = in.val[order[2]];
+        vst3q_u8(dst + i * 3, out);
+    }
+#elif defined(__SSSE3__)
+    // five pixels per 16 byte load, the 16th byte is rewritten by the next step
+    GLubyte m[16];
+    for (int j = 0; j < 15; j++) {
+        m[j] = (j / 3) * 3 + order[j % 3];
+    }
+    m[15] = 15;
+    const __m128i mask = _mm_loadu_si128((const __m128i *)m);
+    for (; i + 6 <= pixels; i += 5) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+        _mm_storeu_si128((__m128i *)(dst + i * 3), _mm_shuffle_epi8(v, mask));
+    }
+#endif
+    for (; i < pixels; i++) {
+        const GLubyte *s = src + i * 3;
+        GLubyte *d = dst + i * 3;
+        d[0] = s[order[0]];
+        d[1] = s[order[1]];
+        d[2] = s[order[2]];
+    }
+}
+
+// 3 bytes -> 4 bytes, reordered with an opaque alpha
+static void kernel_expand3(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t in = vld3q_u8(src + i * 3);
+        uint8x16x4_t out;
+        out.val[0] = in.val[order[0]];
+        out.val[1] = in.val[order[1]];
+        out.val[2] = in.val[order[2]];
+        out.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dst + i * 4, out);
+    }
+#elif defined(__SSSE3__)
+    GLubyte m[16];
+    for (int j = 0; j < 16; j++) {
+        // 0x80 zeroes the alpha byte, it's or'd in after
+        m[j] = (j & 3) == 3 ? 0x80 : (j >> 2) * 3 + order[j & 3];
+    }
+    const __m128i mask = _mm_loadu_si128((const __m128i *)m);
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    // four pixels per step, reading 16 of the 12 bytes
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+    }
+#endif
+    for (; i < pixels; i++) {
+        const GLubyte *s = src + i * 3;
+        GLubyte *d = dst + i * 4;
+        d[0] = s[order[0]];
+        d[1] = s[order[1]];
+        d[2] = s[order[2]];
+        d[3] = 255;
+    }
+}
+
+// 4 bytes -> 3 bytes, reordered, dropping one
+static void kernel_pack4(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t in = vld4q_u8(src + i * 4);
+        uint8x16x3_t out;
+        out.val[0] = in.val[order[0]];
+        out.val[1] = in.val[order[1]];
+        out.val[2] = in.val[order[2]];
+        vst3q_u8(dst + i * 3, out);
+    }
+#elif defined(__SSSE3__)
+    GLubyte m[16];
+    for (int j = 0; j < 16; j++) {
+        m[j] = j < 12 ? (j / 3) * 4 + order[j % 3] : 0x80;
+    }
+    const __m128i mask = _mm_loadu_si128((const __m128i *)m);
+    // four pixels per step, writing 16 of the 12 bytes
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        _mm_storeu_si128((__m128i *)(dst + i * 3), _mm_shuffle_epi8(v, mask));
+    }
+#endif
+    for (; i < pixels; i++) {
+        const GLubyte *s = src + i * 4;
+        GLubyte *d = dst + i * 3;
+        d[0] = s[order[0]];
+        d[1] = s[order[1]];
+        d[2] = s[order[2]];
+    }
+}
+
+// 1 byte -> 2 bytes, for intensity stored as luminance alpha
+static void kernel_splat2(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x2_t out;
+        out.val[0] = out.val[1] = vld1q_u8(src + i);
+        vst2q_u8(dst + i * 2, out);
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(v, v));
+    }
+#endif
+    for (; i < pixels; i++) {
+        dst[i * 2] = dst[i * 2 + 1] = src[i];
+    }
+}
+
+// same bytes, different meaning; order[0] is the pixel size
+static void kernel_copy(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    memcpy(dst, src, pixels * order[0]);
+}
+
+// RGBA floats -> RGBA bytes, clamped and rounded
+static void kernel_float_ubyte(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    const GLfloat *s = (const GLfloat *)src;
+    GLuint i = 0, n = pixels * 4;
+#if defined(__ARM_NEON__)
+    const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+    const float32x4_t scale = vdupq_n_f32(255.0f), half = vdupq_n_f32(0.5f);
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(s + i), zero), one);
+        float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(s + i + 4), zero), one);
+        uint32x4_t ia = vcvtq_u32_f32(vmlaq_f32(half, a, scale));
+        uint32x4_t ib = vcvtq_u32_f32(vmlaq_f32(half, b, scale));
+        uint16x8_t w = vcombine_u16(vmovn_u32(ia), vmovn_u32(ib));
+        vst1_u8(dst + i, vmovn_u16(w));
+    }
+#elif defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v[4];
+        for (int j = 0; j < 4; j++) {
+            __m128 f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(s + i + j * 4), zero), one);
+            v[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, scale), half));
+        }
+        __m128i w = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128((__m128i *)(dst + i), w);
+    }
+#endif
+    for (; i < n; i++) {
+        GLfloat f = s[i];
+        f = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+        dst[i] = (GLubyte)(f * 255.0f + 0.5f);
+    }
+}
+
+// BGRA 1_5_5_5_REV -> RGBA 5_5_5_1, which is a one bit rotate
+static void kernel_1555_5551(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    const GLushort *s = (const GLushort *)src;
+    GLushort *d = (GLushort *)dst;
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 8 <= pixels; i += 8) {
+        uint16x8_t v = vld1q_u16(s + i);
+        vst1q_u16(d + i, vorrq_u16(vshlq_n_u16(v, 1), vshrq_n_u16(v, 15)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= pixels; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_or_si128(_mm_slli_epi16(v, 1), _mm_srli_epi16(v, 15)));
+    }
+#endif
+    for (; i < pixels; i++) {
+        d[i] = (s[i] << 1) | (s[i] >> 15);
+    }
+}
+
+/*
+RGB(A) bytes -> 16 bit, with a 4x4 ordered dither on the color channels so
+gradients don't band. Alpha is truncated; 5_5_5_1 is only picked for alpha
+that's already 0 or 255. `order` gives the source bytes of r, g, b and a.
+*/
+
+static const GLubyte bayer4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+// dither bias for a channel keeping `bits` bits
+#define dither_bias(b, bits) ((b) >> ((bits) - 4))
+
+static inline GLubyte dither_add(GLubyte v, GLubyte bias) {
+    return v > 255 - bias ? 255 : v + bias;
+}
+
+static inline GLushort pack_pixel(GLubyte r, GLubyte g, GLubyte b, GLubyte a, GLubyte d, GLenum type) {
+    switch (type) {
+        case GL_UNSIGNED_SHORT_5_6_5:
+            r = dither_add(r, dither_bias(d, 5));
+            g = dither_add(g, dither_bias(d, 6));
+            b = dither_add(b, dither_bias(d, 5));
+            return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+            r = dither_add(r, d);
+            g = dither_add(g, d);
+            b = dither_add(b, d);
+            return ((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) | (a >> 4);
+        default:
+            r = dither_add(r, dither_bias(d, 5));
+            g = dither_add(g, dither_bias(d, 5));
+            b = dither_add(b, dither_bias(d, 5));
+            return ((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) | (a >> 7);
+    }
+}
+
+#if defined(__ARM_NEON__)
+static inline uint16x8_t neon_pack(uint8x8_t r, uint8x8_t g, uint8x8_t b, uint8x8_t a, GLenum type) {
+    uint16x8_t out = vshll_n_u8(r, 8);
+    switch (type) {
+        case GL_UNSIGNED_SHORT_5_6_5:
+            out = vsriq_n_u16(out, vshll_n_u8(g, 8), 5);
+            return vsriq_n_u16(out, vshll_n_u8(b, 8), 11);
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+            out = vsriq_n_u16(out, vshll_n_u8(g, 8), 4);
+            out = vsriq_n_u16(out, vshll_n_u8(b, 8), 8);
+            return vsriq_n_u16(out, vshll_n_u8(a, 8), 12);
+        default:
+            out = vsriq_n_u16(out, vshll_n_u8(g, 8), 5);
+            out = vsriq_n_u16(out, vshll_n_u8(b, 8), 10);
+            return vsriq_n_u16(out, vshll_n_u8(a, 8), 15);
+    }
+}
+#elif defined(__SSE2__)
+// four RGBA pixels in 32 bit lanes -> 16 bit values in the same lanes
+static inline __m128i sse_pack(__m128i v, GLenum type) {
+    #define left(mask, n) _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(mask)), n)
+    #define right(mask, n) _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(mask)), n)
+    __m128i out;
+    switch (type) {
+        case GL_UNSIGNED_SHORT_5_6_5:
+            out = _mm_or_si128(left(0xf8, 8), _mm_or_si128(right(0xfc00, 5), right(0xf80000, 19)));
+            break;
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+            out = _mm_or_si128(_mm_or_si128(left(0xf0, 8), right(0xf000, 4)),
+                               _mm_or_si128(right(0xf00000, 16), _mm_srli_epi32(v, 28)));
+            break;
+        default:
+            out = _mm_or_si128(_mm_or_si128(left(0xf8, 8), right(0xf800, 5)),
+                               _mm_or_si128(right(0xf80000, 18), _mm_srli_epi32(v, 31)));
+            break;
+    }
+    #undef left
+    #undef right
+    return out;
+}
+#endif
+
+static inline void dither_pack(const GLubyte *src, GLubyte *dst, GLuint pixels,
+                               const GLubyte *order, GLuint row, GLuint size, GLenum type) {
+    GLushort *d = (GLushort *)dst;
+    const GLubyte *bayer = bayer4[row & 3];
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    // per channel biases for 16 pixels, the pattern repeats every 4
+    uint8x16_t bias5, bias6, bias4;
+    {
+        GLubyte b5[16], b6[16], b4[16];
+        for (int j = 0; j < 16; j++) {
+            b4[j] = bayer[j & 3];
+            b5[j] = dither_bias(b4[j], 5);
+            b6[j] = dither_bias(b4[j], 6);
+        }
+        bias4 = vld1q_u8(b4);
+        bias5 = vld1q_u8(b5);
+        bias6 = vld1q_u8(b6);
+    }
+    uint8x16_t rb = type == GL_UNSIGNED_SHORT_4_4_4_4 ? bias4 : bias5;
+    uint8x16_t gb = type == GL_UNSIGNED_SHORT_5_6_5 ? bias6 : rb;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16_t r, g, b, a;
+        if (size == 4) {
+            uint8x16x4_t in = vld4q_u8(src + i * 4);
+            r = in.val[order[0]];
+            g = in.val[order[1]];
+            b = in.val[order[2]];
+            a = in.val[order[3]];
+        } else {
+            uint8x16x3_t in = vld3q_u8(src + i * 3);
+            r = in.val[order[0]];
+            g = in.val[order[1]];
+            b = in.val[order[2]];
+            a = vdupq_n_u8(255);
+        }
+        r = vqaddq_u8(r, rb);
+        g = vqaddq_u8(g, gb);
+        b = vqaddq_u8(b, rb);
+        vst1q_u16(d + i, neon_pack(vget_low_u8(r), vget_low_u8(g), vget_low_u8(b), vget_low_u8(a), type));
+        vst1q_u16(d + i + 8, neon_pack(vget_high_u8(r), vget_high_u8(g), vget_high_u8(b), vget_high_u8(a), type));
+    }
+#elif defined(__SSE2__)
+    // RGBA and BGRA only, SSE2 can't reorder bytes beyond swapping R and B
+    bool rgba = order[0] == 0 && order[1] == 1 && order[2] == 2 && order[3] == 3;
+    bool bgra = order[0] == 2 && order[1] == 1 && order[2] == 0 && order[3] == 3;
+    if (size == 4 && (rgba || bgra)) {
+        GLubyte b[16];
+        for (int j = 0; j < 16; j++) {
+            GLubyte v = bayer[j >> 2];
+            switch (type) {
+                case GL_UNSIGNED_SHORT_5_6_5:
+                    v = dither_bias(v, (j & 3) == 1 ? 6 : 5);
+                    break;
+                case GL_UNSIGNED_SHORT_5_5_5_1:
+                    v = dither_bias(v, 5);
+                    break;
+            }
+            b[j] = (j & 3) == 3 ? 0 : v;
+        }
+        const __m128i bias = _mm_loadu_si128((const __m128i *)b);
+        const __m128i ga = _mm_set1_epi32(0xff00ff00), rb = _mm_set1_epi32(0x000000ff);
+        const __m128i flip = _mm_set1_epi32(0x8000), unflip = _mm_set1_epi16(0x8000);
+        for (; i + 8 <= pixels; i += 8) {
+            __m128i v[2];
+            for (int j = 0; j < 2; j++) {
+                __m128i p = _mm_loadu_si128((const __m128i *)(src + (i + j * 4) * 4));
+                if (bgra) {
+                    p = _mm_or_si128(_mm_and_si128(p, ga),
+                        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), rb),
+                                     _mm_slli_epi32(_mm_and_si128(p, rb), 16)));
+                }
+                // packs is signed, so move the 16 bit values into its range and back
+                v[j] = _mm_sub_epi32(sse_pack(_mm_adds_epu8(p, bias), type), flip);
+            }
+            _mm_storeu_si128((__m128i *)(d + i), _mm_add_epi16(_mm_packs_epi32(v[0], v[1]), unflip));
+        }
+    }
+#endif
+    for (; i < pixels; i++) {
+        const GLubyte *s = src + i * size;
+        d[i] = pack_pixel(s[order[0]], s[order[1]], s[order[2]], size == 4 ? s[order[3]] : 255,
+                          bayer[i & 3], type);
+    }
+}
+
+static void kernel_dither565(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    dither_pack(src, dst, pixels, order, row, 4, GL_UNSIGNED_SHORT_5_6_5);
+}
+
+static void kernel_dither565_3(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    dither_pack(src, dst, pixels, order, row, 3, GL_UNSIGNED_SHORT_5_6_5);
+}
+
+static void kernel_dither4444(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    dither_pack(src, dst, pixels, order, row, 4, GL_UNSIGNED_SHORT_4_4_4_4);
+}
+
+static void kernel_dither5551(const GLubyte *src, GLubyte *dst, GLuint pixels, const GLubyte *order, GLuint row) {
+    dither_pack(src, dst, pixels, order, row, 4, GL_UNSIGNED_SHORT_5_5_5_1);
+}
+
+static const struct {
+    GLenum src_format, src_type, dst_format, dst_type;
+    pixel_kernel_t kernel;
+    GLubyte order[4];
+    // needs each row's position, so rows can't be merged
+    bool dither;
+} pixel_kernels[] = {
+    // 8_8_8_8_REV is byte order on little endian, 8_8_8_8 is reversed
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, kernel_shuffle4, {2, 1, 0, 3}},
+    {GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGBA, GL_UNSIGNED_BYTE, kernel_shuffle4, {2, 1, 0, 3}},
+    {GL_BGRA, GL_UNSIGNED_INT_8_8_8_8, GL_RGBA, GL_UNSIGNED_BYTE, kernel_shuffle4, {1, 2, 3, 0}},
+    {GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, GL_RGBA, GL_UNSIGNED_BYTE, kernel_shuffle4, {3, 2, 1, 0}},
+    {GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGBA, GL_UNSIGNED_BYTE, kernel_shuffle4, {0, 1, 2, 3}},
+    // opaque four channel data stored as RGB
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, kernel_pack4, {0, 1, 2}},
+    {GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGB, GL_UNSIGNED_BYTE, kernel_pack4, {0, 1, 2}},
+    {GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, GL_RGB, GL_UNSIGNED_BYTE, kernel_pack4, {3, 2, 1}},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, kernel_pack4, {2, 1, 0}},
+    {GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGB, GL_UNSIGNED_BYTE, kernel_pack4, {2, 1, 0}},
+    {GL_BGRA, GL_UNSIGNED_INT_8_8_8_8, GL_RGB, GL_UNSIGNED_BYTE, kernel_pack4, {1, 2, 3}},
+    // single channels
+    {GL_RED, GL_UNSIGNED_BYTE, GL_LUMINANCE, GL_UNSIGNED_BYTE, kernel_copy, {1}},
+    {GL_INTENSITY, GL_UNSIGNED_BYTE, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, kernel_splat2},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, kernel_shuffle3, {2, 1, 0}},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, kernel_expand3, {2, 1, 0}},
+    {GL_RGB, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, kernel_expand3, {0, 1, 2}},
+    {GL_RGBA, GL_FLOAT, GL_RGBA, GL_UNSIGNED_BYTE, kernel_float_ubyte},
+    {GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, kernel_1555_5551},
+    // 16 bit storage
+    #define dither(format, type, dst_format, dst_type, kernel, ...) \
+        {format, type, dst_format, dst_type, kernel, __VA_ARGS__, true}
+    dither(GL_RGB, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, kernel_dither565_3, {0, 1, 2}),
+    dither(GL_BGR, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, kernel_dither565_3, {2, 1, 0}),
+    dither(GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, kernel_dither565, {0, 1, 2, 3}),
+    dither(GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, kernel_dither565, {2, 1, 0, 3}),
+    dither(GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, kernel_dither565, {0, 1, 2, 3}),
+    dither(GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, kernel_dither565, {2, 1, 0, 3}),
+    dither(GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, kernel_dither4444, {0, 1, 2, 3}),
+    dither(GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, kernel_dither4444, {2, 1, 0, 3}),
+    dither(GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, kernel_dither4444, {0, 1, 2, 3}),
+    dither(GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, kernel_dither4444, {2, 1, 0, 3}),
+    dither(GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, kernel_dither5551, {0, 1, 2, 3}),
+    dither(GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, kernel_dither5551, {2, 1, 0, 3}),
+    dither(GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, kernel_dither5551, {0, 1, 2, 3}),
+    dither(GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, kernel_dither5551, {2, 1, 0, 3}),
+    #undef dither
+};
+
+static int find_kernel(GLenum src_format, GLenum src_type, GLenum dst_format, GLenum dst_type) {
+    for (int i = 0; i < sizeof(pixel_kernels) / sizeof(pixel_kernels[0]); i++) {
+        if (pixel_kernels[i].src_format == src_format && pixel_kernels[i].src_type == src_type &&
+            pixel_kernels[i].dst_format == dst_format && pixel_kernels[i].dst_type == dst_type) {
+            return i;
+        }
+    }
+    return PIXEL_REMAP;
+}
+
+// looks up how to convert between two formats, once for a whole image
+bool pixel_converter(pixel_converter_t *conv,
+                     GLenum src_format, GLenum src_type,
+                     GLenum dst_format, GLenum dst_type) {
+    conv->src_color = get_color_map(src_format);
+    conv->dst_color = get_color_map(dst_format);
+    conv->src_type = src_type;
+    conv->dst_type = dst_type;
+    conv->src_size = gl_pixel_sizeof(src_format, src_type);
+    conv->dst_size = gl_pixel_sizeof(dst_format, dst_type);
+    if (! conv->src_size || ! conv->dst_size ||
+        ! conv->src_color->type || ! conv->dst_color->type) {
+        return false;
+    }
+    if (src_type == dst_type && conv->src_color->type == conv->dst_color->type) {
+        conv->kernel = PIXEL_COPY;
+        return true;
+    }
+    conv->kernel = find_kernel(src_format, src_type, dst_format, dst_type);
+    if (conv->kernel == PIXEL_REMAP) {
+        // the types are the same for every pixel, so one is enough to check
+        GLubyte src[32] = {0}, dst[32];
+        return remap_pixel(src, dst, conv->src_color, src_type, conv->dst_color, dst_type);
+    }
+    return true;
+}
+
+// converts `rows` rows of `width` pixels, each row starting a stride after the last
+void pixel_convert_rows(const pixel_converter_t *conv,
+                        const GLvoid *src, GLsizei src_stride,
+                        GLvoid *dst, GLsizei dst_stride,
+                        GLuint width, GLuint rows, GLuint y) {
+    // packed rows convert in one go
+    bool dither = conv->kernel >= 0 && pixel_kernels[conv->kernel].dither;
+    if (! dither && src_stride == width * conv->src_size && dst_stride == width * conv->dst_size) {
+        width *= rows;
+        rows = 1;
+    }
+    const GLubyte *src_row = src;
+    GLubyte *dst_row = dst;
+    for (GLuint end = y + rows; y < end; y++) {
+        switch (conv->kernel) {
+            case PIXEL_COPY:
+                memcpy(dst_row, src_row, width * conv->dst_size);
+                break;
+            case PIXEL_REMAP: {
+                const GLubyte *s = src_row;
+                GLubyte *d = dst_row;
+                for (int x = 0; x < width; x++) {
+                    remap_pixel(s, d, conv->src_color, conv->src_type, conv->dst_color, conv->dst_type);
+                    s += conv->src_size;
+                    d += conv->dst_size;
+                }
+                break;
+            }
+            default:
+                pixel_kernels[conv->kernel].kernel(src_row, dst_row, width, pixel_kernels[conv->kernel].order, y);
+                break;
+        }
+        src_row += src_stride;
+        dst_row += dst_stride;
+    }
+}
+
 bool pixel_convert(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
                    GLenum src_format, GLenum src_type,
                    GLenum dst_format, GLenum dst_type) {
-    const colorlayout_t *src_color, *dst_color;
-    GLuint pixels = width * height;
-    GLuint dst_size = pixels * gl_pixel_sizeof(dst_format, dst_type);
-
+    pixel_converter_t conv;
     // printf("pixel conversion: %ix%i - %i, %i -> %i, %i\n", width, height, src_format, src_type, dst_format, dst_type);
-    src_color = get_color_map(src_format);
-    dst_color = get_color_map(dst_format);
-    if (!dst_size || !gl_pixel_sizeof(src_format, src_type)
-        || !src_color->type || !dst_color->type)
+    if (! pixel_converter(&conv, src_format, src_type, dst_format, dst_type)) {
+        return false;
+    }
+    if (conv.kernel == PIXEL_COPY && *dst == src) {
         return false;
+    }
+    *dst = malloc(width * height * conv.dst_size);
+    pixel_convert_rows(&conv, src, width * conv.src_size, *dst, width * conv.dst_size, width, height, 0);
+    return true;
+}
 
-    if (src_type == dst_type && src_color->type == dst_color->type) {
-        if (*dst != src) {
-            *dst = malloc(dst_size);
-            memcpy(*dst, src, dst_size);
+bool pixel_byte_channels(GLenum type) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_INT_8_8_8_8:
+        case GL_UNSIGNED_INT_8_8_8_8_REV:
             return true;
+    }
+    return false;
+}
+
+// 2x2 box filter of 4 byte pixels, `width` output pixels at a time
+static GLuint box2_rgba(const GLubyte *top, const GLubyte *bottom, GLubyte *dst, GLuint width) {
+    GLuint i = 0;
+#if defined(__ARM_NEON__)
+    for (; i + 4 <= width; i += 4) {
+        // even and odd pixels of both rows
+        uint32x4x2_t t = vld2q_u32((const uint32_t *)(top + i * 8));
+        uint32x4x2_t b = vld2q_u32((const uint32_t *)(bottom + i * 8));
+        uint8x16_t te = vreinterpretq_u8_u32(t.val[0]), to = vreinterpretq_u8_u32(t.val[1]);
+        uint8x16_t be = vreinterpretq_u8_u32(b.val[0]), bo = vreinterpretq_u8_u32(b.val[1]);
+        uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(te), vget_low_u8(to)),
+                                  vaddl_u8(vget_low_u8(be), vget_low_u8(bo)));
+        uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(te), vget_high_u8(to)),
+                                  vaddl_u8(vget_high_u8(be), vget_high_u8(bo)));
+        vst1q_u8(dst + i * 4, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(2);
+    for (; i + 4 <= width; i += 4) {
+        __m128i sum[4];
+        for (int j = 0; j < 2; j++) {
+            __m128i t = _mm_loadu_si128((const __m128i *)(top + i * 8 + j * 16));
+            __m128i b = _mm_loadu_si128((const __m128i *)(bottom + i * 8 + j * 16));
+            // each half holds two neighbouring pixels, summed down the columns
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(t, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(b, zero));
+            sum[j * 2] = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            sum[j * 2 + 1] = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
         }
-    } else {
-        GLsizei src_stride = gl_pixel_sizeof(src_format, src_type);
-        GLsizei dst_stride = gl_pixel_sizeof(dst_format, dst_type);
-        *dst = malloc(dst_size);
-        uintptr_t src_pos = (uintptr_t)src;
-        uintptr_t dst_pos = (uintptr_t)*dst;
-        for (int i = 0; i < pixels; i++) {
-            if (! remap_pixel((const GLvoid *)src_pos, (GLvoid *)dst_pos,
-                              src_color, src_type, dst_color, dst_type)) {
-                // checking a boolean for each pixel like this might be a slowdown?
-                // probably depends on how well branch prediction performs
-                return false;
+        __m128i first = _mm_unpacklo_epi64(sum[0], sum[1]);
+        __m128i second = _mm_unpacklo_epi64(sum[2], sum[3]);
+        first = _mm_srli_epi16(_mm_add_epi16(first, round), 2);
+        second = _mm_srli_epi16(_mm_add_epi16(second, round), 2);
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(first, second));
+    }
+#endif
+    return i;
+}
+
+void pixel_shrink_row(const pixel_converter_t *conv,
+                      const GLvoid *src, GLsizei src_stride,
+                      GLvoid *dst, GLuint width, GLuint step) {
+    const GLubyte *in = src;
+    GLubyte *out = dst;
+    GLuint size = conv->src_size;
+    if (! pixel_byte_channels(conv->src_type)) {
+        for (GLuint x = 0; x < width; x++) {
+            memcpy(out + x * size, in + x * step * size, size);
+        }
+        return;
+    }
+    GLuint x = 0;
+    if (step == 2 && size == 4) {
+        x = box2_rgba(in, in + src_stride, out, width);
+    }
+    GLuint area = step * step;
+    for (; x < width; x++) {
+        const GLubyte *block = in + x * step * size;
+        for (GLuint c = 0; c < size; c++) {
+            GLuint sum = area / 2;
+            for (GLuint y = 0; y < step; y++) {
+                const GLubyte *p = block + y * src_stride + c;
+                for (GLuint i = 0; i < step; i++) {
+                    sum += p[i * size];
+                }
             }
-            src_pos += src_stride;
-            dst_pos += dst_stride;
+            out[x * size + c] = sum / area;
         }
-        return true;
     }
-    return false;
 }
 
 bool pixel_scale(const GLvoid *old, GLvoid **new,
@@ -186,20 +799,32 @@ bool pixel_scale(const GLvoid *old, GLvoid **new,
     GLuint pixel_size, new_width, new_height;
     new_width = width * ratio;
     new_height = height * ratio;
-    printf("scaling %ux%u -> %ux%u\n", width, height, new_width, new_height);
-    GLvoid *dst;
-    uintptr_t src, pos, pixel;
-
+    if (! new_width || ! new_height) {
+        return false;
+    }
     pixel_size = gl_pixel_sizeof(format, type);
-    dst = malloc(pixel_size * new_width * new_height);
-    src = (uintptr_t)old;
-    pos = (uintptr_t)dst;
-    for (int x = 0; x < new_width; x++) {
-        for (int y = 0; y < new_height; y++) {
-            pixel = src + (x / ratio) +
-                          (y / ratio) * width;
-            memcpy((GLvoid *)pos, (GLvoid *)pixel, pixel_size);
-            pos += pixel_size;
+    GLubyte *dst = malloc(pixel_size * new_width * new_height);
+    if (! dst) {
+        return false;
+    }
+    const GLubyte *src = old;
+    GLuint step = 1 / ratio + 0.5f;
+    if (ratio < 1 && step * new_width <= width && step * new_height <= height) {
+        // whole shrink factors are box filtered
+        pixel_converter_t conv = {
+            .src_type = type, .src_size = pixel_size,
+        };
+        for (GLuint y = 0; y < new_height; y++) {
+            pixel_shrink_row(&conv, src + y * step * width * pixel_size, width * pixel_size,
+                             dst + y * new_width * pixel_size, new_width, step);
+        }
+    } else {
+        for (GLuint y = 0; y < new_height; y++) {
+            const GLubyte *row = src + (GLuint)(y / ratio) * width * pixel_size;
+            for (GLuint x = 0; x < new_width; x++) {
+                memcpy(dst + (y * new_width + x) * pixel_size,
+                       row + (GLuint)(x / ratio) * pixel_size, pixel_size);
+            }
         }
     }
     *new = dst;
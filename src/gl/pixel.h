@@ -13,11 +13,42 @@ typedef struct {
     GLfloat r, g, b, a;
 } pixel_t;
 
+// pixel_converter_t.kernel, when it isn't an index into the kernel table
+#define PIXEL_COPY  -2
+#define PIXEL_REMAP -1
+
+typedef struct {
+    const colorlayout_t *src_color, *dst_color;
+    GLenum src_type, dst_type;
+    // bytes per pixel
+    GLsizei src_size, dst_size;
+    int kernel;
+} pixel_converter_t;
+
+bool pixel_converter(pixel_converter_t *conv,
+                     GLenum src_format, GLenum src_type,
+                     GLenum dst_format, GLenum dst_type);
+
+// y is the first row's place in the image, for dithering
+void pixel_convert_rows(const pixel_converter_t *conv,
+                        const GLvoid *src, GLsizei src_stride,
+                        GLvoid *dst, GLsizei dst_stride,
+                        GLuint width, GLuint rows, GLuint y);
+
 bool pixel_convert(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
                    GLenum src_format, GLenum src_type,
                    GLenum dst_format, GLenum dst_type);
 
+// types where each byte is a channel of its own
+bool pixel_byte_channels(GLenum type);
+
+// averages `step` rows of `width * step` pixels down to `width`, a box filter
+// for byte channels and point sampling otherwise
+void pixel_shrink_row(const pixel_converter_t *conv,
+                      const GLvoid *src, GLsizei src_stride,
+                      GLvoid *dst, GLuint width, GLuint step);
+
 bool pixel_scale(const GLvoid *src, GLvoid **dst,
                   GLuint width, GLuint height,
                   GLfloat ratio,
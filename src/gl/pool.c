@@ -0,0 +1,187 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+/*
+Worker threads for splitting CPU heavy work, like texture conversion, into
+bands. The calling thread works on the bands too and pool_run() returns once
+all of them are done, so GL calls stay on the GL thread.
+
+pool_submit() queues a task on a separate background thread instead, for work
+the GL thread only needs later; pool_wait() blocks until a task is done.
+
+LIBGL_THREADS=n  threads to use, counting the calling one (default: one per
+                 core, up to MAX_POOL_THREADS). 1 turns the pool off.
+*/
+
+static struct {
+    bool init;
+    int threads;
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    // the current job
+    pool_fn fn;
+    void *arg;
+    int count, next, pending;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+// background tasks, run one at a time in submission order
+static struct {
+    bool init, thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queued, done;
+    pool_task_t *head, *tail;
+} tasks = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .queued = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+// takes parts of the current job until none are left, called with the lock held
+static void pool_work() {
+    while (pool.next < pool.count) {
+        int index = pool.next++;
+        pthread_mutex_unlock(&pool.lock);
+        pool.fn(pool.arg, index, pool.count);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0) {
+            pthread_cond_signal(&pool.done);
+        }
+    }
+}
+
+static void *pool_worker(void *unused) {
+    pthread_mutex_lock(&pool.lock);
+    while (true) {
+        while (pool.next >= pool.count) {
+            pthread_cond_wait(&pool.start, &pool.lock);
+        }
+        pool_work();
+    }
+    return NULL;
+}
+
+static void pool_init() {
+    if (pool.init)
+        return;
+    pool.init = true;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cores > 0 ? cores : 1;
+    char *env_threads = getenv("LIBGL_THREADS");
+    if (env_threads && *env_threads) {
+        threads = strtol(env_threads, NULL, 10);
+    }
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > MAX_POOL_THREADS) {
+        threads = MAX_POOL_THREADS;
+    }
+
+    pool.threads = 1;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (int i = 1; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, pool_worker, NULL) != 0) {
+            break;
+        }
+        pool.threads++;
+    }
+    pthread_attr_destroy(&attr);
+    char *env_stats = getenv("LIBGL_TEXSTATS");
+    if (pool.threads > 1 && env_stats && strcmp(env_stats, "1") == 0) {
+        printf("libGL: using %d threads for texture conversion\n", pool.threads);
+    }
+}
+
+// threads a job can be spread over, including the caller
+int pool_threads() {
+    pool_init();
+    return pool.threads;
+}
+
+void pool_run(pool_fn fn, void *arg, int count) {
+    pool_init();
+    if (pool.threads == 1 || count == 1) {
+        for (int i = 0; i < count; i++) {
+            fn(arg, i, count);
+        }
+        return;
+    }
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.pending = count;
+    pool.next = 0;
+    pool.count = count;
+    pthread_cond_broadcast(&pool.start);
+    pool_work();
+    while (pool.pending) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void *task_worker(void *unused) {
+    pthread_mutex_lock(&tasks.lock);
+    while (true) {
+        while (! tasks.head) {
+            pthread_cond_wait(&tasks.queued, &tasks.lock);
+        }
+        pool_task_t *task = tasks.head;
+        tasks.head = task->next;
+        if (! tasks.head) {
+            tasks.tail = NULL;
+        }
+        pthread_mutex_unlock(&tasks.lock);
+        task->fn(task->arg, 0, 1);
+        pthread_mutex_lock(&tasks.lock);
+        task->done = true;
+        pthread_cond_broadcast(&tasks.done);
+    }
+    return NULL;
+}
+
+void pool_submit(pool_task_t *task) {
+    if (! tasks.init) {
+        tasks.init = true;
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        tasks.thread = pthread_create(&thread, &attr, task_worker, NULL) == 0;
+        pthread_attr_destroy(&attr);
+    }
+    task->done = false;
+    task->next = NULL;
+    if (! tasks.thread) {
+        // no thread to hand it to
+        task->fn(task->arg, 0, 1);
+        task->done = true;
+        return;
+    }
+    pthread_mutex_lock(&tasks.lock);
+    if (tasks.tail) {
+        tasks.tail->next = task;
+    } else {
+        tasks.head = task;
+    }
+    tasks.tail = task;
+    pthread_cond_signal(&tasks.queued);
+    pthread_mutex_unlock(&tasks.lock);
+}
+
+void pool_wait(pool_task_t *task) {
+    pthread_mutex_lock(&tasks.lock);
+    while (! task->done) {
+        pthread_cond_wait(&tasks.done, &tasks.lock);
+    }
+    pthread_mutex_unlock(&tasks.lock);
+}
@@ -0,0 +1,22 @@
+#include "gl.h"
+
+#ifndef POOL_H
+#define POOL_H
+
+// a job is split into count parts, fn is called once for each
+typedef void (*pool_fn)(void *arg, int index, int count);
+
+// work for the background thread, fn is called as fn(arg, 0, 1)
+typedef struct pool_task {
+    pool_fn fn;
+    void *arg;
+    bool done;
+    struct pool_task *next;
+} pool_task_t;
+
+extern int pool_threads();
+extern void pool_run(pool_fn fn, void *arg, int count);
+extern void pool_submit(pool_task_t *task);
+extern void pool_wait(pool_task_t *task);
+
+#endif
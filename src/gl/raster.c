@@ -1,5 +1,6 @@
 #include "error.h"
 #include "loader.h"
+#include "matrix.h"
 #include "pixel.h"
 #include "raster.h"
 #include "texture.h"
@@ -202,6 +203,7 @@ void render_raster() {
                  0, GL_RGBA, GL_UNSIGNED_BYTE, state.raster.buf);
 
     LOAD_GLES(glDrawArrays);
+    gl_matrix_flush();
     gles_glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
     glDeleteTextures(1, &texture);
 
@@ -150,15 +150,28 @@ static inline int _index(block_t *block, int i) {
     return i;
 }
 
-static inline GLfloat *_vert(block_t *block, int i) {
-    return &block->vert[_index(block, i) * 3];
+static inline GLfloat *_vert(block_t *block, GLfloat *verts, int i) {
+    return &verts[_index(block, i) * 3];
 }
 
-static void select_match(block_t *block, GLfloat zmin, GLfloat zmax, int i) {
+// transforms all of a block's vertices in one pass, into memory reused
+// across blocks
+static GLfloat *transform_block(block_t *block) {
+    static GLfloat *verts = NULL;
+    static GLsizei cap = 0;
+    if (block->vert_len > cap) {
+        cap = block->vert_len;
+        verts = realloc(verts, cap * 3 * sizeof(GLfloat));
+    }
+    gl_transform_vertices(verts, block->vert, block->vert_len);
+    return verts;
+}
+
+static void select_match(block_t *block, GLfloat *verts, GLfloat zmin, GLfloat zmax, int i) {
 #define push(val) state.select.buffer[state.select.count++] = val;
-    GLfloat cur[3];
+    GLfloat *cur;
     for (; i < block->len; i++) {
-        gl_transform_vertex(cur, _vert(block, i));
+        cur = _vert(block, verts, i);
         zmin = MIN(zmin, cur[2]);
         zmax = MAX(zmax, cur[2]);
     }
@@ -182,19 +195,17 @@ void gl_select_block(block_t *block) {
         return;
     }
     GLfloat zmax = 0.0f, zmin = 1.0f;
-#define test(func, ...) if (test_##func(__VA_ARGS__)) { select_match(block, zmin, zmax, i); return; }
+#define test(func, ...) if (test_##func(__VA_ARGS__)) { select_match(block, verts, zmin, zmax, i); return; }
 #define test_point(a) test(point, a)
 #define test_line(a, b) test(line, a, b)
 #define test_tri(a, b, c) test(tri, a, b, c)
-    GLfloat data[3][3], first[3], *tmp;
-    GLfloat *a = data[0], *b = data[1], *c = data[2];
-    gl_transform_vertex(first, _vert(block, 0));
+    GLfloat *verts = transform_block(block);
+    GLfloat *first = _vert(block, verts, 0);
+    GLfloat *a = NULL, *b = NULL, *c = NULL;
     for (int i = 0; i < block->len; i++) {
-        tmp = c;
         c = b;
         b = a;
-        a = tmp;
-        gl_transform_vertex(a, _vert(block, i));
+        a = _vert(block, verts, i);
         zmin = MIN(zmin, a[2]);
         zmax = MAX(zmax, a[2]);
         switch (block->mode) {
@@ -328,16 +339,14 @@ static int feedback_sizeof(GLenum type) {
     }
 }
 
-static void feedback_vertex(block_t *block, int i) {
+static void feedback_vertex(block_t *block, GLfloat *verts, int i) {
     static GLfloat color[] = {0, 0, 0, 1};
     static GLfloat tex[] = {0, 0, 0, 0};
-    GLfloat v[4], *c, *t;
+    GLfloat *v = &verts[i * 3], *c, *t;
     c = block->color ?: color;
     // glFeedbackBuffer returns only the texture coordinate of texture unit GL_TEXTURE0.
     t = block->tex[0] ?: tex;
 
-    // TODO: this will be called extra times on stuff like triangle strips
-    gl_transform_vertex(v, &block->vert[i * 3]);
     switch (state.feedback.type) {
         case GL_2D:
             feedback_push_n(v, 2);
@@ -373,7 +382,7 @@ void gl_feedback_block(block_t *block) {
     }
     int size = feedback_sizeof(state.feedback.type);
 
-    GLfloat *v, *c, *t;
+    GLfloat *verts = transform_block(block);
     int v1, v2, v3;
     int first = _index(block, 0);
     for (int j = 0; j < block->len; j++) {
@@ -388,50 +397,50 @@ void gl_feedback_block(block_t *block) {
             case GL_LINES:
                 if (i % 2 == 1) {
                     polygon(2);
-                    feedback_vertex(block, v2);
-                    feedback_vertex(block, v1);
+                    feedback_vertex(block, verts, v2);
+                    feedback_vertex(block, verts, v1);
                 }
                 break;
             case GL_LINE_LOOP:
                 // catch the loop segment
                 if (i == block->len - 1) {
                     polygon(2);
-                    feedback_vertex(block, v1);
-                    feedback_vertex(block, first);
+                    feedback_vertex(block, verts, v1);
+                    feedback_vertex(block, verts, first);
                 }
             case GL_LINE_STRIP:
                 if (i > 0) {
                     polygon(2);
-                    feedback_vertex(block, v2);
-                    feedback_vertex(block, v1);
+                    feedback_vertex(block, verts, v2);
+                    feedback_vertex(block, verts, v1);
                 }
                 break;
             case GL_TRIANGLES:
                 if (i % 3 == 2) {
                     polygon(3);
-                    feedback_vertex(block, v3);
-                    feedback_vertex(block, v2);
-                    feedback_vertex(block, v1);
+                    feedback_vertex(block, verts, v3);
+                    feedback_vertex(block, verts, v2);
+                    feedback_vertex(block, verts, v1);
                 }
             case GL_TRIANGLE_FAN:
                 if (i > 1) {
                     polygon(3);
-                    feedback_vertex(block, v2);
-                    feedback_vertex(block, v1);
-                    feedback_vertex(block, first);
+                    feedback_vertex(block, verts, v2);
+                    feedback_vertex(block, verts, v1);
+                    feedback_vertex(block, verts, first);
                 }
                 break;
             case GL_TRIANGLE_STRIP:
                 if (i > 1) {
                     polygon(3);
-                    feedback_vertex(block, v3);
-                    feedback_vertex(block, v2);
-                    feedback_vertex(block, v1);
+                    feedback_vertex(block, verts, v3);
+                    feedback_vertex(block, verts, v2);
+                    feedback_vertex(block, verts, v1);
                 }
                 break;
             case GL_POINTS:
                 polygon(1);
-                feedback_vertex(block, v1);
+                feedback_vertex(block, verts, v1);
                 break;
             default:
                 printf("warning: unsupported GL_SELECT mode: %s\n", gl_str(block->mode));
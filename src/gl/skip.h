@@ -1,6 +1,15 @@
 // don't auto-wrap these functions
 #define skip_glColor4ub
 
+// buffer.c
+#define skip_glBindBuffer
+#define skip_glBufferData
+#define skip_glBufferSubData
+#define skip_glDeleteBuffers
+#define skip_glGenBuffers
+#define skip_glGetBufferParameteriv
+#define skip_glIsBuffer
+
 // clear.c
 #define skip_glClear
 #define skip_glClearColor
@@ -27,6 +36,7 @@
 #define skip_glGetString
 
 // matrix.cpp
+#define skip_glClipPlanef
 #define skip_glFrustumf
 #define skip_glLoadIdentity
 #define skip_glLoadMatrixf
@@ -41,9 +51,7 @@
 
 // light.c
 #define skip_glLightModelf
-#ifdef LOCAL_MATRIX
 #define skip_glLightfv
-#endif
 #define skip_glMaterialfv
 
 // raster.c
@@ -53,9 +61,13 @@
 #define skip_glActiveTexture
 #define skip_glBindTexture
 #define skip_glClientActiveTexture
+#define skip_glCopyTexImage2D
+#define skip_glCopyTexSubImage2D
 #define skip_glDeleteTextures
+#define skip_glFinish
 #define skip_glMultiTexCoord4f
 #define skip_glPixelStorei
+#define skip_glReadPixels
 #define skip_glTexEnvf
 #define skip_glTexImage2D
 #define skip_glTexParameteri
@@ -1,3 +1,4 @@
+#include "buffer.h"
 #include "error.h"
 #include "stack.h"
 
@@ -190,6 +191,8 @@ void glPushClientAttrib(GLbitfield mask) {
         memcpy(&cur->color, &state.pointers.color, sizeof(pointer_state_t));
         memcpy(&cur->normal, &state.pointers.normal, sizeof(pointer_state_t));
         memcpy(&cur->tex, &state.pointers.tex_coord, sizeof(pointer_state_t) * MAX_TEX);
+        cur->array_buffer = state.buffers.array ? state.buffers.array->buffer : 0;
+        cur->element_buffer = state.buffers.element ? state.buffers.element->buffer : 0;
     }
     tack_push(&state.stack.client, cur);
 }
@@ -371,6 +374,10 @@ void glPopClientAttrib() {
         memcpy(&state.pointers.color, &cur->color, sizeof(pointer_state_t));
         memcpy(&state.pointers.normal, &cur->normal, sizeof(pointer_state_t));
         memcpy(&state.pointers.tex_coord, &cur->tex, sizeof(pointer_state_t) * MAX_TEX);
+        glBindBuffer(GL_ARRAY_BUFFER, cur->array_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cur->element_buffer);
+        // the GLES arrays still point wherever they were set since the push
+        gles_arrays_rebase(0);
     }
     free(cur);
 }
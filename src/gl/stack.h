@@ -125,6 +125,8 @@ typedef struct {
     pointer_state_t color;
     pointer_state_t normal;
     pointer_state_t tex[MAX_TEX];
+    GLuint array_buffer;
+    GLuint element_buffer;
 } glclientstack_t;
 
 void glPushClientAttrib(GLbitfield mask);
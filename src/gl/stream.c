@@ -0,0 +1,141 @@
+#include "stream.h"
+#include "buffer.h"
+#include "loader.h"
+
+/*
+Streams client vertex data through a ring of GLES buffer objects, so draws
+reference buffer offsets instead of making the driver copy client memory.
+
+LIBGL_STREAM=1         enable streaming
+LIBGL_STREAM_SIZE=n    size of each buffer in KB (default 1024)
+LIBGL_STREAM_FRAMES=n  buffers in the ring (default 2). Each frame writes to
+                       the next one, trusting the GPU to be done with a
+                       buffer after n frames. With 0 a single buffer is
+                       orphaned every frame instead.
+
+A buffer that fills up mid-frame is orphaned and reused from the start,
+which counts as a wrap. Draws reserve all their arrays up front, so a wrap
+never orphans arrays an unfinished draw still points at.
+*/
+
+static struct {
+    bool init, enabled;
+    GLuint *buffers;
+    GLuint count, current;
+    GLsizeiptr size, offset;
+    // orphan the current buffer before the next write
+    bool orphan;
+    // LIBGL_STREAM_FRAMES=0: orphan at every frame instead of rotating
+    bool orphan_frames;
+    stream_stats_t frame, last;
+} stream = {0};
+
+static GLuint env_int(const char *name, GLuint fallback) {
+    char *value = getenv(name);
+    if (value && *value) {
+        return strtoul(value, NULL, 10);
+    }
+    return fallback;
+}
+
+static void stream_init() {
+    if (stream.init)
+        return;
+    stream.init = true;
+
+    char *env_stream = getenv("LIBGL_STREAM");
+    if (! env_stream || strcmp(env_stream, "1") != 0) {
+        return;
+    }
+    stream.enabled = true;
+    stream.size = env_int("LIBGL_STREAM_SIZE", 1024) * 1024;
+    GLuint frames = env_int("LIBGL_STREAM_FRAMES", 2);
+    stream.count = frames ? frames : 1;
+    stream.orphan_frames = (frames == 0);
+    stream.buffers = calloc(stream.count, sizeof(GLuint));
+    printf("libGL: streaming vertex arrays through %u x %u KB buffers\n",
+           stream.count, (GLuint)(stream.size / 1024));
+
+    LOAD_GLES(glGenBuffers);
+    LOAD_GLES(glBufferData);
+    gles_glGenBuffers(stream.count, stream.buffers);
+    for (int i = 0; i < stream.count; i++) {
+        gles_buffer_bind(GL_ARRAY_BUFFER, stream.buffers[i]);
+        gles_glBufferData(GL_ARRAY_BUFFER, stream.size, NULL, GL_DYNAMIC_DRAW);
+    }
+    gles_buffers_restore();
+}
+
+bool stream_enabled() {
+    stream_init();
+    return stream.enabled;
+}
+
+static void stream_bind() {
+    LOAD_GLES(glBufferData);
+    gles_buffer_bind(GL_ARRAY_BUFFER, stream.buffers[stream.current]);
+    if (stream.orphan) {
+        gles_glBufferData(GL_ARRAY_BUFFER, stream.size, NULL, GL_DYNAMIC_DRAW);
+        stream.orphan = false;
+    }
+}
+
+// starts over in an orphaned buffer unless size more bytes fit
+static void stream_fit(GLsizeiptr size) {
+    if (stream.offset + size > stream.size) {
+        stream.orphan = true;
+        stream.offset = 0;
+        stream.frame.wraps++;
+    }
+}
+
+// makes room for every array of one draw, each padded to 4 bytes. false if
+// they can't share a buffer, and the draw should use client memory instead
+bool stream_reserve(GLsizeiptr size) {
+    if (! stream_enabled() || size > stream.size) {
+        return false;
+    }
+    stream_fit(size);
+    return true;
+}
+
+// returns what to hand gl*Pointer: an offset into the ring with it bound, or
+// the original data with no buffer bound if it doesn't fit
+const GLvoid *stream_pointer(const GLvoid *data, GLsizeiptr size) {
+    if (! stream_enabled() || ! data || size > stream.size) {
+        stream_unbind();
+        return data;
+    }
+    stream_fit(size);
+    stream_bind();
+
+    LOAD_GLES(glBufferSubData);
+    gles_glBufferSubData(GL_ARRAY_BUFFER, stream.offset, size, data);
+    const GLvoid *offset = (const GLvoid *)stream.offset;
+    // keep every array 4-byte aligned
+    stream.offset += (size + 3) & ~3;
+    stream.frame.bytes += size;
+    stream.frame.uploads++;
+    return offset;
+}
+
+// client pointers need no array buffer bound
+void stream_unbind() {
+    gles_buffer_bind(GL_ARRAY_BUFFER, 0);
+}
+
+// called once per frame, from glXSwapBuffers
+void stream_frame() {
+    if (! stream.enabled)
+        return;
+    stream.last = stream.frame;
+    memset(&stream.frame, 0, sizeof(stream_stats_t));
+    stream.current = (stream.current + 1) % stream.count;
+    stream.offset = 0;
+    stream.orphan = stream.orphan_frames;
+}
+
+// counters from the last complete frame
+void stream_stats(stream_stats_t *stats) {
+    *stats = stream.last;
+}
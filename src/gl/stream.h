@@ -0,0 +1,20 @@
+#include "gl.h"
+
+#ifndef STREAM_H
+#define STREAM_H
+
+// per-frame counters for the streaming vertex buffer ring
+typedef struct {
+    GLuint bytes;
+    GLuint uploads;
+    GLuint wraps;
+} stream_stats_t;
+
+extern bool stream_enabled();
+extern bool stream_reserve(GLsizeiptr size);
+extern const GLvoid *stream_pointer(const GLvoid *data, GLsizeiptr size);
+extern void stream_unbind();
+extern void stream_frame();
+extern void stream_stats(stream_stats_t *stats);
+
+#endif
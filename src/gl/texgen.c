@@ -1,7 +1,9 @@
+#include <stddef.h>
 #include <stdio.h>
 
 #include "block.h"
 #include "error.h"
+#include "matrix.h"
 #include "texgen.h"
 #include "vectorial/simd4f.h"
 #include "vectorial/simd4x4f.h"
@@ -24,7 +26,6 @@ void glTexGenfv(GLenum coord, GLenum pname, const GLfloat *param) {
                 }
             case GL_OBJECT_LINEAR:
             case GL_EYE_LINEAR:
-            // TODO: missing GL_NORMAL_MAP implementation
             case GL_NORMAL_MAP:
             case GL_REFLECTION_MAP:
                 break;
@@ -60,113 +61,250 @@ void glTexGenfv(GLenum coord, GLenum pname, const GLfloat *param) {
     }
 }
 
-static inline void tex_coord_loop(block_t *block, GLfloat *out, GLenum type, GLfloat *Sp, GLfloat *Tp) {
-    GLfloat *vert = block->vert;
-    GLfloat *normal = block->normal;
-    // if we get sphere map and no normal, just barf and return?
+// rows of a matrix as splatted vectors, to transform four vertices at once
+#define splat_row(m, c) { simd4f_splat_##c((m)->x), simd4f_splat_##c((m)->y), \
+                          simd4f_splat_##c((m)->z), simd4f_splat_##c((m)->w) }
+#define dot3(r, x, y, z) simd4f_add(simd4f_add(simd4f_mul(x, r[0]), simd4f_mul(y, r[1])), \
+                                    simd4f_mul(z, r[2]))
+#define dot4(r, x, y, z) simd4f_add(dot3(r, x, y, z), r[3])
 
-    simd4x4f matrix;
-    if (type != GL_OBJECT_LINEAR) {
-        // TODO: make sure this loads it properly
-        glGetFloatv(GL_MODELVIEW_MATRIX, (float *)&matrix);
+static bool is_vector_mode(GLenum mode) {
+    return mode == GL_SPHERE_MAP || mode == GL_REFLECTION_MAP || mode == GL_NORMAL_MAP;
+}
+
+// loads the next (up to) four xyz triples, zero padded
+static inline void load_xyz(const GLfloat *src, int left, simd4f *x, simd4f *y, simd4f *z) {
+    if (left >= 4) {
+        simd4f_uload3x4(src, x, y, z);
+        return;
     }
-    simd4f s_plane, t_plane;
-    s_plane = simd4f_uload4(Sp);
-    if (Tp != NULL) {
-        t_plane = simd4f_uload4(Tp);
+    GLfloat tail[12] = {0};
+    memcpy(tail, src, left * 3 * sizeof(GLfloat));
+    simd4f_uload3x4(tail, x, y, z);
+}
+
+// writes (up to) four s or t values into interleaved st pairs
+static inline void store_coord(GLfloat *out, int left, simd4f v) {
+    GLfloat tmp[4];
+    simd4f_ustore4(v, tmp);
+    for (int j = 0; j < 4 && j < left; j++) {
+        out[j * 2] = tmp[j];
+    }
+}
+
+static void linear_loop(const GLfloat *vert, GLsizei count, simd4f plane, GLfloat *out) {
+    const simd4f p[4] = {
+        simd4f_splat_x(plane), simd4f_splat_y(plane),
+        simd4f_splat_z(plane), simd4f_splat_w(plane),
+    };
+    simd4f x, y, z;
+    for (int i = 0; i < count; i += 4) {
+        load_xyz(vert + i * 3, count - i, &x, &y, &z);
+        store_coord(out + i * 2, count - i, dot4(p, x, y, z));
     }
-    for (int i = 0; i < block->len; i++) {
-        if (! block->normal) {
-            normal = CURRENT->normal;
+}
+
+// sphere, reflection and normal maps, from eye space positions and normals
+static void vector_loop(block_t *block, const simd4x4f *modelview, const simd4x4f *normal_matrix,
+                        GLenum mode, GLfloat *out, bool gen_s, bool gen_t) {
+    const simd4f mx[4] = splat_row(modelview, x),
+                 my[4] = splat_row(modelview, y),
+                 mz[4] = splat_row(modelview, z);
+    const simd4f nmx[4] = splat_row(normal_matrix, x),
+                 nmy[4] = splat_row(normal_matrix, y),
+                 nmz[4] = splat_row(normal_matrix, z);
+    const simd4f one = simd4f_splat(1.0f), two = simd4f_splat(2.0f), half = simd4f_splat(0.5f);
+    GLsizei count = block->vert_len;
+
+    simd4f nx = simd4f_zero(), ny = simd4f_zero(), nz = simd4f_zero();
+    if (! block->normal) {
+        GLfloat *n = CURRENT->normal;
+        simd4f x = simd4f_splat(n[0]), y = simd4f_splat(n[1]), z = simd4f_splat(n[2]);
+        nx = dot3(nmx, x, y, z);
+        ny = dot3(nmy, x, y, z);
+        nz = dot3(nmz, x, y, z);
+    }
+    for (int i = 0; i < count; i += 4) {
+        int left = count - i;
+        simd4f x, y, z, s, t;
+        if (block->normal) {
+            load_xyz(block->normal + i * 3, left, &x, &y, &z);
+            nx = dot3(nmx, x, y, z);
+            ny = dot3(nmy, x, y, z);
+            nz = dot3(nmz, x, y, z);
         }
-        GLfloat tmp[2];
-        simd4f v = simd4f_create(vert[0], vert[1], vert[2], 1);
-        switch (type) {
-            case GL_OBJECT_LINEAR:
-                simd4f_ustore2(simd4f_dot4(v, s_plane), tmp);
-                out[0] = tmp[0];
-                if (Tp) {
-                    simd4f_ustore2(simd4f_dot4(v, t_plane), tmp);
-                    out[1] = tmp[0];
-                }
-                break;
-            case GL_EYE_LINEAR: {
-                simd4f eye;
-                simd4x4f_matrix_vector_mul(&matrix, &v, &eye);
-                simd4f_ustore2(simd4f_dot4(eye, s_plane), tmp);
-                out[0] = tmp[0];
-                if (Tp) {
-                    simd4f_ustore2(simd4f_dot4(eye, t_plane), tmp);
-                    out[1] = tmp[0];
-                }
-                break;
-            }
-            case GL_SPHERE_MAP: {
-                simd4f norm = simd4f_create(normal[0], normal[1], normal[2], 1.0f);
-                simd4f eye;
-                simd4x4f_matrix_vector_mul(&matrix, &v, &eye);
-                eye = simd4f_normalize3(eye);
-                simd4f eye_normal;
-
-                simd4x4f inverse;
-                simd4x4f_inverse(&matrix, &inverse);
-                // TODO: better to use new registers to prevent stall?
-                simd4x4f_transpose_inplace(&inverse);
-                // TODO: is normal multiplied wrong here?
-                simd4x4f_matrix_vector_mul(&inverse, &norm, &eye_normal);
-                simd4f result = simd4f_mul(simd4f_dot4(eye, eye_normal), simd4f_create(2.0f, 2.0f, 2.0f, 2.0f));
-                simd4f reflection = simd4f_sub(eye, simd4f_mul(eye_normal, result));
-                reflection = simd4f_add(reflection, simd4f_create(0.0f, 0.0f, 1.0f, 0.0f));
-                float ref[4], dot[2];
-                simd4f_ustore2(reflection, ref);
-                simd4f_ustore2(simd4f_dot4(reflection, reflection), dot);
-                float m = 1.0 / (2.0 * sqrt(dot[0]));
-                out[0] = ref[0] * m + 0.5;
-                out[1] = ref[1] * m + 0.5;
-
-                normal += 3;
-                break;
-            }
-            case GL_REFLECTION_MAP: {
-                float eye_[2], eye_normal_[2], dot[2];
-                simd4f norm = simd4f_create(normal[0], normal[1], normal[2], 1.0f);
-                simd4f eye;
-                simd4x4f_matrix_vector_mul(&matrix, &v, &eye);
-                eye = simd4f_normalize3(eye);
-                simd4f_ustore2(eye, eye_);
-
-                simd4f eye_normal;
-                simd4x4f inverse;
-                simd4x4f_inverse(&matrix, &inverse);
-                simd4x4f_transpose_inplace(&inverse);
-                simd4x4f_matrix_vector_mul(&inverse, &norm, &eye_normal);
-                simd4f_ustore2(eye_normal, eye_);
-
-                simd4f_ustore2(simd4f_dot4(eye, eye_normal), dot);
-                out[0] = eye_[0] - eye_normal_[0] * dot[0] * 2.0f;
-                out[1] = eye_[1] - eye_normal_[1] * dot[0] * 2.0f;
-                // out[2] = eye.x - eye_normal.z * dot;
-                break;
+        if (mode == GL_NORMAL_MAP) {
+            s = nx;
+            t = ny;
+        } else {
+            load_xyz(block->vert + i * 3, left, &x, &y, &z);
+            simd4f ex = dot4(mx, x, y, z), ey = dot4(my, x, y, z), ez = dot4(mz, x, y, z);
+            simd4f len = simd4f_sqrt(simd4f_add(simd4f_add(simd4f_mul(ex, ex), simd4f_mul(ey, ey)),
+                                                simd4f_mul(ez, ez)));
+            simd4f inv = simd4f_div(one, len);
+            ex = simd4f_mul(ex, inv);
+            ey = simd4f_mul(ey, inv);
+            ez = simd4f_mul(ez, inv);
+            // r = u - 2n(n.u)
+            simd4f d = simd4f_add(simd4f_add(simd4f_mul(nx, ex), simd4f_mul(ny, ey)), simd4f_mul(nz, ez));
+            d = simd4f_mul(two, d);
+            simd4f rx = simd4f_sub(ex, simd4f_mul(nx, d)),
+                   ry = simd4f_sub(ey, simd4f_mul(ny, d)),
+                   rz = simd4f_sub(ez, simd4f_mul(nz, d));
+            if (mode == GL_REFLECTION_MAP) {
+                s = rx;
+                t = ry;
+            } else {
+                // m = 2 * sqrt(rx^2 + ry^2 + (rz + 1)^2)
+                rz = simd4f_add(rz, one);
+                simd4f m = simd4f_sqrt(simd4f_add(simd4f_add(simd4f_mul(rx, rx), simd4f_mul(ry, ry)),
+                                                  simd4f_mul(rz, rz)));
+                m = simd4f_div(half, m);
+                s = simd4f_add(simd4f_mul(rx, m), half);
+                t = simd4f_add(simd4f_mul(ry, m), half);
             }
         }
-        out += 2;
-        vert += 3;
+        if (gen_s) {
+            store_coord(out + i * 2, left, s);
+        }
+        if (gen_t) {
+            store_coord(out + i * 2 + 1, left, t);
+        }
     }
 }
 
-void gen_tex_coords(block_t *block, GLuint texture) {
-    // TODO: do less work when called from glDrawElements?
+// inverse transpose of the upper 3x3: its columns are the cross products of
+// the modelview's columns over the determinant, no full 4x4 inverse needed
+static void get_normal_matrix(const simd4x4f *modelview, simd4x4f *out) {
+    simd4f yz = simd4f_cross3(modelview->y, modelview->z);
+    simd4f inv = simd4f_splat(1.0f / simd4f_get_x(simd4f_dot3(modelview->x, yz)));
+    out->x = simd4f_mul(yz, inv);
+    out->y = simd4f_mul(simd4f_cross3(modelview->z, modelview->x), inv);
+    out->z = simd4f_mul(simd4f_cross3(modelview->x, modelview->y), inv);
+    out->w = simd4f_zero();
+}
+
+// fills one generated coordinate, out points at the s or t of the first pair
+static void gen_coord(block_t *block, GLenum mode, const GLfloat *plane, const simd4x4f *modelview,
+                      const simd4x4f *normal_matrix, GLfloat *out, bool is_s) {
+    simd4f p = simd4f_uload4(plane);
+    switch (mode) {
+        case GL_OBJECT_LINEAR:
+            linear_loop(block->vert, block->vert_len, p, out);
+            break;
+        case GL_EYE_LINEAR: {
+            // p . (M v) == (M^T p) . v, so fold the modelview into the plane once
+            simd4f folded = simd4f_create(
+                simd4f_get_x(simd4f_dot4(modelview->x, p)),
+                simd4f_get_x(simd4f_dot4(modelview->y, p)),
+                simd4f_get_x(simd4f_dot4(modelview->z, p)),
+                simd4f_get_x(simd4f_dot4(modelview->w, p)));
+            linear_loop(block->vert, block->vert_len, folded, out);
+            break;
+        }
+        default:
+            vector_loop(block, modelview, normal_matrix, mode, out - (is_s ? 0 : 1), is_s, ! is_s);
+            break;
+    }
+}
 
-    block->tex[texture] = (GLfloat *)malloc(block->len * 2 * sizeof(GLfloat));
+// writes glTexGen output for a texture unit into storage the block keeps
+// between draws, and returns it
+GLfloat *gen_tex_coords(block_t *block, GLuint texture) {
     texgen_state_t *texgen = &state.texgen[texture];
-    if (state.enable.texgen_s[texture]) {
-        if (texgen->S == texgen->T) {
-            tex_coord_loop(block, block->tex[texture], texgen->S, texgen->Sv, texgen->Tv);
+    bool gen_s = state.enable.texgen_s[texture], gen_t = state.enable.texgen_t[texture];
+    GLsizei count = block->vert_len;
+    GLfloat *out = block->texgen[texture];
+    if (! out) {
+        out = block->texgen[texture] = malloc(count * 2 * sizeof(GLfloat));
+    }
+    // a coordinate that isn't generated comes from the block or the current texcoord
+    if (! (gen_s && gen_t)) {
+        if (block->tex[texture]) {
+            memcpy(out, block->tex[texture], count * 2 * sizeof(GLfloat));
         } else {
-            tex_coord_loop(block, block->tex[texture], texgen->S, texgen->Sv, NULL);
+            GLfloat *cur = CURRENT->tex[texture];
+            for (int i = 0; i < count; i++) {
+                out[i * 2 + 0] = cur[0];
+                out[i * 2 + 1] = cur[1];
+            }
+        }
+    }
+
+    // the matrices are the same for every vertex of the draw
+    simd4x4f modelview, normal_matrix;
+    GLfloat m[16];
+    gl_get_matrix(GL_MODELVIEW, m);
+    simd4x4f_uload(&modelview, m);
+    if ((gen_s && is_vector_mode(texgen->S)) || (gen_t && is_vector_mode(texgen->T))) {
+        get_normal_matrix(&modelview, &normal_matrix);
+    }
+
+    if (gen_s && gen_t && texgen->S == texgen->T && is_vector_mode(texgen->S)) {
+        vector_loop(block, &modelview, &normal_matrix, texgen->S, out, true, true);
+        return out;
+    }
+    if (gen_s) {
+        gen_coord(block, texgen->S, texgen->Sv, &modelview, &normal_matrix, out, true);
+    }
+    if (gen_t) {
+        gen_coord(block, texgen->T, texgen->Tv, &modelview, &normal_matrix, out + 1, false);
+    }
+    return out;
+}
+
+static bool uses_modelview(GLenum mode) {
+    return mode == GL_EYE_LINEAR || is_vector_mode(mode);
+}
+
+// fills in what a block's glTexGen output for a texture unit depends on
+void texgen_key(texgen_key_t *key, block_t *block, GLuint texture) {
+    memset(key, 0, sizeof(texgen_key_t));
+    texgen_state_t *texgen = &state.texgen[texture];
+    key->texgen = *texgen;
+    key->s = state.enable.texgen_s[texture];
+    key->t = state.enable.texgen_t[texture];
+    if (! block->normal) {
+        memcpy(key->normal, CURRENT->normal, sizeof(key->normal));
+    }
+    if (! block->tex[texture] && ! (key->s && key->t)) {
+        memcpy(key->tex, CURRENT->tex[texture], sizeof(key->tex));
+    }
+    if ((key->s && uses_modelview(texgen->S)) || (key->t && uses_modelview(texgen->T))) {
+        GLfloat m[16];
+        gl_get_matrix(GL_MODELVIEW, m);
+        simd4x4f_uload(&key->modelview, m);
+        key->modelview_version = state.matrix.model.version;
+    }
+}
+
+// whether output generated for `cached` is still good for `key`. a new
+// modelview version with the same matrix is taken over by the cached key
+bool texgen_key_match(texgen_key_t *cached, const texgen_key_t *key) {
+    if (memcmp(cached, key, offsetof(texgen_key_t, modelview_version))) {
+        return false;
+    }
+    if (cached->modelview_version != key->modelview_version) {
+        if (memcmp(&cached->modelview, &key->modelview, sizeof(simd4x4f))) {
+            return false;
         }
+        cached->modelview_version = key->modelview_version;
+    }
+    return true;
+}
+
+// glTexGen output for a block, only regenerated when its inputs changed since
+// the last draw, so static display lists under a static camera cost nothing
+GLfloat *texgen_coords(block_t *block, GLuint texture) {
+    texgen_key_t key;
+    texgen_key(&key, block, texture);
+    texgen_key_t *cached = block->texgen_key[texture];
+    if (block->texgen[texture] && cached && texgen_key_match(cached, &key)) {
+        return block->texgen[texture];
     }
-    if (state.enable.texgen_t[texture]) {
-        tex_coord_loop(block, block->tex[texture] + 1, texgen->T, texgen->Tv, NULL);
+    if (! cached) {
+        cached = block->texgen_key[texture] = malloc(sizeof(texgen_key_t));
     }
+    *cached = key;
+    return gen_tex_coords(block, texture);
 }
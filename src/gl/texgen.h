@@ -1,4 +1,7 @@
 #include <GL/gl.h>
 #include "block.h"
 
-extern void gen_tex_coords(block_t *block, GLuint texture);
+extern GLfloat *gen_tex_coords(block_t *block, GLuint texture);
+extern GLfloat *texgen_coords(block_t *block, GLuint texture);
+extern void texgen_key(texgen_key_t *key, block_t *block, GLuint texture);
+extern bool texgen_key_match(texgen_key_t *cached, const texgen_key_t *key);
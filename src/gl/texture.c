@@ -1,11 +1,15 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <time.h>
 
+#include "budget.h"
 #include "error.h"
+#include "etc1.h"
 #include "gl_helpers.h"
 #include "gl_str.h"
 #include "loader.h"
 #include "pixel.h"
+#include "pool.h"
 #include "texture.h"
 #include "types.h"
 
@@ -47,103 +51,997 @@ void tex_coord_npot(GLfloat *tex, GLsizei len,
     }
 }
 
-static void *swizzle_texture(GLsizei width, GLsizei height,
-                             GLenum *format, GLenum *type,
-                             const GLvoid *data) {
-    bool convert = false;
+// the channels a texture samples with, from its internal format
+static GLenum internal_base(GLint internal) {
+    switch (internal) {
+        case 1:
+        case GL_LUMINANCE:
+        case GL_LUMINANCE4:
+        case GL_LUMINANCE8:
+        case GL_LUMINANCE12:
+        case GL_LUMINANCE16:
+            return GL_LUMINANCE;
+        case 2:
+        case GL_LUMINANCE_ALPHA:
+        case GL_LUMINANCE4_ALPHA4:
+        case GL_LUMINANCE6_ALPHA2:
+        case GL_LUMINANCE8_ALPHA8:
+        case GL_LUMINANCE12_ALPHA4:
+        case GL_LUMINANCE12_ALPHA12:
+        case GL_LUMINANCE16_ALPHA16:
+            return GL_LUMINANCE_ALPHA;
+        case GL_ALPHA:
+        case GL_ALPHA4:
+        case GL_ALPHA8:
+        case GL_ALPHA12:
+        case GL_ALPHA16:
+            return GL_ALPHA;
+        case GL_INTENSITY:
+        case GL_INTENSITY4:
+        case GL_INTENSITY8:
+        case GL_INTENSITY12:
+        case GL_INTENSITY16:
+            return GL_INTENSITY;
+        case 3:
+        case GL_RGB:
+        case GL_R3_G3_B2:
+        case GL_RGB4:
+        case GL_RGB5:
+        case GL_RGB8:
+        case GL_RGB10:
+        case GL_RGB12:
+        case GL_RGB16:
+        case GL_RED:
+        case GL_RG:
+            return GL_RGB;
+    }
+    return GL_RGBA;
+}
+
+static bool single_channel(GLenum format) {
+    return format == GL_LUMINANCE || format == GL_RED || format == GL_INTENSITY;
+}
+
+/*
+The smallest GLES format that still holds everything the texture samples:
+what the internal format keeps of the app's channels. Intensity is stored as
+luminance alpha, read from single channel data with the value in both.
+*/
+static GLenum storage_base(GLenum internal, GLenum *format) {
+    bool alpha, color;
     switch (*format) {
         case GL_ALPHA:
+            alpha = true;
+            color = false;
+            break;
+        case GL_LUMINANCE:
+        case GL_INTENSITY:
+            alpha = color = false;
+            break;
+        case GL_LUMINANCE_ALPHA:
+            alpha = true;
+            color = false;
+            break;
+        case GL_RED:
+        case GL_RG:
         case GL_RGB:
-        case GL_RGBA:
+        case GL_BGR:
+            alpha = false;
+            color = true;
+            break;
+        default:
+            alpha = color = true;
+            break;
+    }
+    bool luminance = ! color && *format != GL_ALPHA;
+    switch (internal) {
+        case GL_ALPHA:
+            return GL_ALPHA;
         case GL_LUMINANCE:
+            return GL_LUMINANCE;
+        case GL_INTENSITY:
+            if (single_channel(*format)) {
+                *format = GL_INTENSITY;
+                return GL_LUMINANCE_ALPHA;
+            }
+            break;
         case GL_LUMINANCE_ALPHA:
+            if (*format == GL_ALPHA) {
+                return GL_ALPHA;
+            }
+            return alpha ? GL_LUMINANCE_ALPHA : GL_LUMINANCE;
+        case GL_RGB:
+            return color ? GL_RGB : GL_LUMINANCE;
+    }
+    if (! color) {
+        return luminance ? (alpha ? GL_LUMINANCE_ALPHA : GL_LUMINANCE) : GL_ALPHA;
+    }
+    return alpha ? GL_RGBA : GL_RGB;
+}
+
+// where the app's first row starts and how far apart its rows are, from the unpack state
+static const GLubyte *unpack_rows(const GLvoid *data, GLsizei width, GLsizei pixel_size, GLsizei *stride) {
+    GLsizei row_length = state.texture.unpack_row_length ? state.texture.unpack_row_length : width;
+    GLsizei align = state.texture.unpack_alignment;
+    *stride = (row_length * pixel_size + align - 1) / align * align;
+    return (const GLubyte *)data +
+           state.texture.unpack_skip_rows * *stride +
+           state.texture.unpack_skip_pixels * pixel_size;
+}
+
+typedef enum {
+    ALPHA_GRADED,
+    ALPHA_BINARY,
+    ALPHA_OPAQUE,
+} alpha_t;
+
+// what 8 bit alpha data holds; only tells binary from graded when asked to
+static alpha_t alpha_kind(GLsizei width, GLsizei height,
+                          GLenum format, GLenum type, const GLvoid *data, bool binary) {
+    GLsizei offset;
+    switch (format) {
+        case GL_LUMINANCE_ALPHA:
+            offset = 1;
+            break;
+        case GL_RGBA:
+        case GL_BGRA:
+            offset = 3;
             break;
         default:
-            convert = true;
+            return ALPHA_GRADED;
+    }
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_INT_8_8_8_8_REV:
+            break;
+        case GL_UNSIGNED_INT_8_8_8_8:
+            offset = 0;
             break;
+        default:
+            return ALPHA_GRADED;
     }
+    GLsizei size = gl_pixel_sizeof(format, type), stride;
+    const GLubyte *row = unpack_rows(data, width, size, &stride) + offset;
+    GLubyte all = 255;
+    for (GLsizei y = 0; y < height; y++, row += stride) {
+        GLubyte opaque = 255, graded = 0;
+        for (GLsizei x = 0; x < width; x++) {
+            GLubyte a = row[x * size];
+            opaque &= a;
+            // only 0 and 255 wrap to 1 and 0
+            graded |= (GLubyte)(a + 1) > 1;
+        }
+        all &= opaque;
+        if (graded || (! binary && opaque != 255)) {
+            return ALPHA_GRADED;
+        }
+    }
+    return all == 255 ? ALPHA_OPAQUE : ALPHA_BINARY;
+}
+
+/*
+LIBGL_16BIT=1      trade quality for memory: store RGB8 textures as 5_6_5, and
+                   RGBA8 as 4_4_4_4, or 5_5_5_1 when alpha is only 0 or 255,
+                   with an ordered dither.
+LIBGL_16BIT_MIN=n  only textures of at least n texels (default 4096), so
+                   fonts and small UI pieces stay sharp.
+LIBGL_16BIT_ALLOW  comma separated texture names or ranges, e.g. 1,5,10-20,
+LIBGL_16BIT_DENY   that do or don't qualify. Deny wins over allow.
+*/
+
+static struct {
+    bool init, enabled;
+    GLuint min;
+    const char *allow, *deny;
+} lossy = {0};
+
+static bool name_listed(const char *list, GLuint name) {
+    while (*list) {
+        char *end;
+        GLuint first = strtoul(list, &end, 10), last = first;
+        if (end == list) {
+            list++;
+            continue;
+        }
+        if (*end == '-') {
+            list = end + 1;
+            last = strtoul(list, &end, 10);
+        }
+        if (name >= first && name <= last) {
+            return true;
+        }
+        list = end;
+    }
+    return false;
+}
+
+static bool lossy_texture(gltexture_t *texture, GLsizei width, GLsizei height) {
+    if (! lossy.init) {
+        lossy.init = true;
+        char *env_16bit = getenv("LIBGL_16BIT");
+        lossy.enabled = env_16bit && strcmp(env_16bit, "1") == 0;
+        char *env_min = getenv("LIBGL_16BIT_MIN");
+        lossy.min = env_min && *env_min ? strtoul(env_min, NULL, 10) : 4096;
+        lossy.allow = getenv("LIBGL_16BIT_ALLOW");
+        lossy.deny = getenv("LIBGL_16BIT_DENY");
+    }
+    if (! lossy.enabled || ! texture || (GLuint)(width * height) < lossy.min) {
+        return false;
+    }
+    if (lossy.deny && name_listed(lossy.deny, texture->texture)) {
+        return false;
+    }
+    return ! lossy.allow || name_listed(lossy.allow, texture->texture);
+}
+
+// picks the GLES format and type to store `base` in, returns whether the pixels need converting
+static bool swizzle_format(GLenum base, GLenum *format, GLenum *type) {
     switch (*type) {
         case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_INT_8_8_8_8_REV:
+            break;
         case GL_UNSIGNED_SHORT_5_6_5:
         case GL_UNSIGNED_SHORT_4_4_4_4:
         case GL_UNSIGNED_SHORT_5_5_5_1:
+            // already as small as GLES goes
+            if (*format == GL_RGB || *format == GL_RGBA) {
+                return false;
+            }
             break;
-        case GL_UNSIGNED_INT_8_8_8_8_REV:
-            *type = GL_UNSIGNED_BYTE;
-            break;
-        default:
-            convert = true;
+        case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+            if (*format == GL_BGRA && base == GL_RGBA) {
+                *format = GL_RGBA;
+                *type = GL_UNSIGNED_SHORT_5_5_5_1;
+                return true;
+            }
             break;
     }
+    bool convert = (*format != base) ||
+                   (*type != GL_UNSIGNED_BYTE && *type != GL_UNSIGNED_INT_8_8_8_8_REV);
+    *format = base;
+    *type = GL_UNSIGNED_BYTE;
+    return convert;
+}
+
+static bool texture_stats() {
+    static int stats = -1;
+    if (stats < 0) {
+        char *env_stats = getenv("LIBGL_TEXSTATS");
+        stats = env_stats && strcmp(env_stats, "1") == 0;
+    }
+    return stats;
+}
 
-    if (convert) {
-        GLvoid *pixels = (GLvoid *)data;
-        if (data) {
-            if (! pixel_convert(data, &pixels, width, height, *format, *type, GL_RGBA, GL_UNSIGNED_BYTE)) {
-                printf("libGL swizzle error: (%s, %s -> RGBA, UNSIGNED_BYTE)\n", gl_str(*format), gl_str(*type));
-                return NULL;
+static double now_ms() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+// whether alpha left out of a texture can be brought back, which needs a
+// copy of its pixels for widen_texture: the budget's, or the ETC1 encoding
+static bool can_narrow(GLenum base, GLenum src_type) {
+    if (budget_enabled()) {
+        return true;
+    }
+    return base == GL_RGBA && etc1_enabled() && pixel_byte_channels(src_type);
+}
+
+/*
+The GLES format and type an upload is stored as. A new texture gets the
+smallest one, leaving out alpha when the pixels are all opaque and there's
+a copy to restore it from, or going down to 16 bits when LIBGL_16BIT allows
+it. Later levels and sub images are converted to match.
+*/
+static bool texture_format(gltexture_t *texture, bool first, GLenum internal,
+                           GLsizei width, GLsizei height, const GLvoid *data,
+                           GLenum *src_format, GLenum src_type,
+                           GLenum *format, GLenum *type) {
+    GLenum base;
+    bool stored = ! first && texture && texture->format;
+    bool lossy = false;
+    alpha_t alpha = ALPHA_GRADED;
+    if (stored) {
+        if (texture->internal == GL_INTENSITY && single_channel(*src_format)) {
+            *src_format = GL_INTENSITY;
+        }
+        base = texture->format;
+    } else {
+        base = storage_base(internal, src_format);
+        lossy = (base == GL_RGB || base == GL_RGBA) && lossy_texture(texture, width, height);
+        if (data && (base == GL_RGBA || base == GL_LUMINANCE_ALPHA) &&
+            ! (texture && texture->keep_alpha)) {
+            alpha = alpha_kind(width, height, *src_format, src_type, data, lossy);
+            if (alpha == ALPHA_OPAQUE && can_narrow(base, src_type)) {
+                base = (base == GL_RGBA) ? GL_RGB : GL_LUMINANCE;
+            } else if (alpha == ALPHA_OPAQUE) {
+                // one bit of alpha still holds it
+                alpha = ALPHA_BINARY;
             }
         }
-        *type = GL_UNSIGNED_BYTE;
-        *format = GL_RGBA;
-        return pixels;
     }
-    return (void *)data;
+    *format = *src_format;
+    *type = src_type;
+    bool convert = swizzle_format(base, format, type);
+    if (stored && (*format != texture->format || *type != texture->type)) {
+        *format = texture->format;
+        *type = texture->type;
+        convert = true;
+    }
+    // opaque textures go to ETC1 instead when they can
+    bool etc1 = *format == GL_RGB && data && etc1_enabled();
+    if (lossy && *type == GL_UNSIGNED_BYTE && ! etc1) {
+        GLsizei size = width * height * gl_pixel_sizeof(*format, *type);
+        if (*format == GL_RGB) {
+            *type = GL_UNSIGNED_SHORT_5_6_5;
+        } else {
+            *type = (alpha == ALPHA_BINARY) ? GL_UNSIGNED_SHORT_5_5_5_1 : GL_UNSIGNED_SHORT_4_4_4_4;
+        }
+        convert = true;
+        if (texture_stats()) {
+            printf("libGL: texture %u: stored as %s, saving %u of %u KB\n",
+                   texture->texture, gl_str(*type),
+                   (size - width * height * 2) / 1024, size / 1024);
+        }
+    }
+    if (! stored && texture) {
+        texture->wide_format = texture->wide_type = 0;
+        if (alpha == ALPHA_OPAQUE) {
+            texture->wide_format = (*format == GL_RGB) ? GL_RGBA : GL_LUMINANCE_ALPHA;
+            texture->wide_type = (lossy && *format == GL_RGB) ? GL_UNSIGNED_SHORT_4_4_4_4 : GL_UNSIGNED_BYTE;
+        } else if (*type == GL_UNSIGNED_SHORT_5_5_5_1) {
+            // one bit of alpha only holds cutouts
+            texture->wide_format = GL_RGBA;
+            texture->wide_type = GL_UNSIGNED_SHORT_4_4_4_4;
+        }
+    }
+    return convert;
 }
 
-void glTexImage2D(GLenum target, GLint level, GLint internalFormat,
-                  GLsizei width, GLsizei height, GLint border,
-                  GLenum format, GLenum type, const GLvoid *data) {
+// what alpha a sub image brings, opaque if its format has none
+static alpha_t sub_alpha(GLsizei width, GLsizei height,
+                         GLenum format, GLenum type, const GLvoid *data) {
+    switch (format) {
+        case GL_ALPHA:
+        case GL_INTENSITY:
+        case GL_LUMINANCE_ALPHA:
+        case GL_RGBA:
+        case GL_BGRA:
+            return alpha_kind(width, height, format, type, data, true);
+    }
+    return ALPHA_OPAQUE;
+}
 
-    ERROR_IN_BLOCK();
-    gltexture_t *bound = state.texture.bound[state.texture.active];
-    GLvoid *pixels = (GLvoid *)data;
-    if (data) {
-        // implements GL_UNPACK_ROW_LENGTH
-        if (state.texture.unpack_row_length && state.texture.unpack_row_length != width) {
-            int imgWidth, pixelSize;
-            pixelSize = gl_pixel_sizeof(format, type);
-            imgWidth = state.texture.unpack_row_length * pixelSize;
-            GLubyte *dst = (GLubyte *)malloc(width * height * pixelSize);
-            pixels = (GLvoid *)dst;
-            const GLubyte *src = (GLubyte *)data;
-            src += state.texture.unpack_skip_pixels + state.texture.unpack_skip_rows * imgWidth;
-            for (int y = 0; y < height; y += 1) {
-                memcpy(dst, src, width * pixelSize);
-                src += imgWidth;
-                dst += width;
+/*
+LIBGL_SHRINK=n        store textures at half the size, n times over, so 1
+                      halves them and 2 quarters them.
+LIBGL_MAX_TEXTURE=n   halve textures until neither side is over n pixels.
+
+Textures over the driver's GL_MAX_TEXTURE_SIZE are halved until they fit.
+Shrinking averages each block of pixels, and the texture's other levels and
+sub images are shrunk to match.
+*/
+
+static struct {
+    bool init;
+    GLsizei step, max;
+} shrink = {0};
+
+// every driver we've met takes this much, larger textures ask it first
+#define TEXTURE_SAFE_SIZE 1024
+
+// how many pixels each side of a new texture is divided by
+static GLsizei shrink_step(GLsizei width, GLsizei height) {
+    if (! shrink.init) {
+        shrink.init = true;
+        char *env_shrink = getenv("LIBGL_SHRINK");
+        GLuint halves = env_shrink ? strtoul(env_shrink, NULL, 10) : 0;
+        shrink.step = 1 << (halves < 8 ? halves : 8);
+        char *env_max = getenv("LIBGL_MAX_TEXTURE");
+        shrink.max = env_max ? strtol(env_max, NULL, 10) : 0;
+    }
+    GLsizei step = shrink.step;
+    GLsizei side = width > height ? width : height;
+    if (side > TEXTURE_SAFE_SIZE) {
+        static GLint driver_max = 0;
+        if (! driver_max) {
+            LOAD_GLES(glGetIntegerv);
+            gles_glGetIntegerv(GL_MAX_TEXTURE_SIZE, &driver_max);
+            if (driver_max <= 0) {
+                driver_max = TEXTURE_SAFE_SIZE;
             }
+            if (! shrink.max || shrink.max > driver_max) {
+                shrink.max = driver_max;
+            }
+        }
+    }
+    if (shrink.max > 0) {
+        while (side / step > shrink.max) {
+            step *= 2;
         }
+    }
+    return step;
+}
 
-        GLvoid *old = pixels;
-        pixels = (GLvoid *)swizzle_texture(width, height, &format, &type, data);
-        if (old != pixels && old != data)
-            free(old);
+// a step can't take a side below one pixel
+static GLsizei clamp_step(GLsizei step, GLsizei width, GLsizei height) {
+    while (step > 1 && (width < step || height < step)) {
+        step /= 2;
+    }
+    return step;
+}
 
-        char *env_shrink = getenv("LIBGL_SHRINK");
-        if (env_shrink && strcmp(env_shrink, "1") == 0) {
-            if (width > 1 && height > 1) {
-                GLvoid *out;
-                GLfloat ratio = 0.5;
-                pixel_scale(pixels, &out, width, height, ratio, format, type);
-                if (out != pixels)
-                    free(out);
-                pixels = out;
-                width *= ratio;
-                height *= ratio;
+// whether the unpack state lets GLES read the app's pixels as they are
+static bool unpack_default(GLsizei width) {
+    return (! state.texture.unpack_row_length || state.texture.unpack_row_length == width) &&
+           ! state.texture.unpack_skip_pixels && ! state.texture.unpack_skip_rows;
+}
+
+// reused by every upload, so it only ever grows to the largest strip
+static GLubyte *scratch_strip(GLsizei size) {
+    static GLubyte *strip = NULL;
+    static GLsizei cap = 0;
+    if (size > cap) {
+        free(strip);
+        strip = malloc(size);
+        cap = strip ? size : 0;
+    }
+    return strip;
+}
+
+// a strip of rows to convert, split into one band per thread
+typedef struct {
+    const pixel_converter_t *conv;
+    const GLubyte *src;
+    GLsizei src_stride, step;
+    GLubyte *dst;
+    GLsizei dst_stride;
+    GLsizei width, rows;
+    // where the strip starts in the image, for dithering
+    GLsizei y;
+    // when shrinking, each band averages the source rows into one here first
+    GLubyte *gather;
+    GLsizei gather_size;
+} strip_job_t;
+
+static void convert_band(void *arg, int index, int count) {
+    strip_job_t *job = arg;
+    const pixel_converter_t *conv = job->conv;
+    GLsizei first = job->rows * index / count, last = job->rows * (index + 1) / count;
+    if (job->step == 1) {
+        pixel_convert_rows(conv, job->src + first * job->src_stride, job->src_stride,
+                           job->dst + first * job->dst_stride, job->dst_stride,
+                           job->width, last - first, job->y + first);
+        return;
+    }
+    GLubyte *row = job->gather + index * job->gather_size;
+    for (GLsizei y = first; y < last; y++) {
+        pixel_shrink_row(conv, job->src + y * job->step * job->src_stride, job->src_stride,
+                         row, job->width, job->step);
+        pixel_convert_rows(conv, row, job->gather_size, job->dst + y * job->dst_stride,
+                           job->dst_stride, job->width, 1, job->y + y);
+    }
+}
+
+/*
+Reads the app's rows honoring the unpack state, converts them (averaging
+each step x step block when shrinking) and uploads them a strip at a time into
+an allocated level, so a conversion never needs a copy of the whole image.
+Large images get a strip per thread, converted in bands on the thread pool.
+*/
+static void upload_rows(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+                        GLsizei width, GLsizei height,
+                        GLenum src_format, GLenum src_type,
+                        GLenum format, GLenum type,
+                        const GLvoid *data, GLsizei step) {
+    pixel_converter_t conv;
+    if (! pixel_converter(&conv, src_format, src_type, format, type)) {
+        printf("libGL swizzle error: (%s, %s -> %s, %s)\n",
+               gl_str(src_format), gl_str(src_type), gl_str(format), gl_str(type));
+        return;
+    }
+    strip_job_t job = {
+        .conv = &conv,
+        .step = step,
+    };
+    job.width = width / job.step;
+    GLsizei out_height = height / job.step;
+    if (! job.width || ! out_height) {
+        return;
+    }
+    double start = texture_stats() ? now_ms() : 0;
+
+    const GLubyte *src = unpack_rows(data, width, conv.src_size, &job.src_stride);
+
+    job.dst_stride = job.width * conv.dst_size;
+    int bands = 1;
+    if (job.dst_stride * out_height >= TEXTURE_THREAD_SIZE) {
+        bands = pool_threads();
+    }
+    GLsizei strip_rows = TEXTURE_STRIP_SIZE * bands / job.dst_stride;
+    if (strip_rows < 1) {
+        strip_rows = 1;
+    } else if (strip_rows > out_height) {
+        strip_rows = out_height;
+    }
+    if (bands > strip_rows) {
+        bands = strip_rows;
+    }
+    job.gather_size = step > 1 ? job.width * conv.src_size : 0;
+    GLubyte *strip = scratch_strip(strip_rows * job.dst_stride + job.gather_size * bands);
+    if (! strip) {
+        ERROR(GL_OUT_OF_MEMORY);
+    }
+    job.dst = strip;
+    job.gather = strip + strip_rows * job.dst_stride;
+
+    LOAD_GLES(glPixelStorei);
+    LOAD_GLES(glTexSubImage2D);
+    // strips are tightly packed
+    bool realign = job.dst_stride % state.texture.unpack_alignment != 0;
+    if (realign) {
+        gles_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    }
+    for (GLsizei y = 0; y < out_height; y += strip_rows) {
+        job.rows = out_height - y;
+        if (job.rows > strip_rows) {
+            job.rows = strip_rows;
+        }
+        job.src = src + y * job.step * job.src_stride;
+        job.y = y;
+        pool_run(convert_band, &job, job.rows < bands ? job.rows : bands);
+        gles_glTexSubImage2D(target, level, xoffset, yoffset + y,
+                             job.width, job.rows, format, type, strip);
+        budget_sub_image(state.texture.bound[state.texture.active], level,
+                         xoffset, yoffset + y, job.width, job.rows, format, type, strip, 1);
+    }
+    if (realign) {
+        gles_glPixelStorei(GL_UNPACK_ALIGNMENT, state.texture.unpack_alignment);
+    }
+
+    if (texture_stats()) {
+        gltexture_t *bound = state.texture.bound[state.texture.active];
+        double ms = now_ms() - start;
+        GLsizei bytes = job.width * out_height * conv.src_size;
+        printf("libGL: texture %u: %s %s -> %s %s, %dx%d in %.2f ms (%.1f MB/s, %d threads)\n",
+               bound ? bound->texture : 0,
+               gl_str(src_format), gl_str(src_type), gl_str(format), gl_str(type),
+               job.width, out_height, ms, ms > 0 ? bytes / ms / 1000.0 : 0.0, bands);
+    }
+}
+
+/*
+LIBGL_ASYNC_TEXTURES=1  glTexImage2D keeps a copy of the pixels and converts
+                        it on a background thread. The GLES upload waits
+                        until the texture is drawn with, changed, or until
+                        glFinish or glReadPixels.
+*/
+
+typedef struct texture_upload {
+    pool_task_t task;
+    gltexture_t *texture;
+    GLenum target, format, type;
+    GLint level, border;
+    pixel_converter_t conv;
+    strip_job_t job;
+    // the app's pixels, then the converted ones
+    GLubyte *src, *pixels;
+    double queued;
+    struct texture_upload *next;
+} texture_upload_t;
+
+// oldest first, so levels and textures upload in the order they were given
+static texture_upload_t *uploads = NULL;
+static GLuint queued_uploads = 0;
+
+static bool async_textures() {
+    static int async = -1;
+    if (async < 0) {
+        char *env_async = getenv("LIBGL_ASYNC_TEXTURES");
+        async = env_async && strcmp(env_async, "1") == 0;
+    }
+    return async;
+}
+
+// runs on the background thread
+static void convert_upload(void *arg, int index, int count) {
+    texture_upload_t *upload = arg;
+    strip_job_t *job = &upload->job;
+    upload->pixels = malloc(job->rows * job->dst_stride);
+    job->gather = malloc(job->gather_size);
+    job->dst = upload->pixels;
+    if (upload->pixels && (job->gather || ! job->gather_size)) {
+        convert_band(job, 0, 1);
+    }
+    free(job->gather);
+    free(upload->src);
+    upload->src = NULL;
+}
+
+static bool queue_upload(gltexture_t *texture, GLenum target, GLint level,
+                         GLsizei width, GLsizei height, GLint border,
+                         GLenum src_format, GLenum src_type,
+                         GLenum format, GLenum type,
+                         const GLvoid *data, bool convert, GLsizei step) {
+    texture_upload_t *upload = calloc(1, sizeof(texture_upload_t));
+    if (! upload) {
+        return false;
+    }
+    if (! pixel_converter(&upload->conv, src_format, src_type, format, type)) {
+        free(upload);
+        return false;
+    }
+    strip_job_t *job = &upload->job;
+    job->conv = &upload->conv;
+    job->step = step;
+    job->width = width / job->step;
+    job->rows = height / job->step;
+    job->dst_stride = job->width * upload->conv.dst_size;
+    job->gather_size = step > 1 ? job->width * upload->conv.src_size : 0;
+
+    // the app may reuse its memory as soon as we return, so its rows are copied packed
+    GLsizei row_size = width * upload->conv.src_size, src_stride;
+    const GLubyte *src = unpack_rows(data, width, upload->conv.src_size, &src_stride);
+    upload->src = malloc(row_size * height);
+    if (! upload->src) {
+        free(upload);
+        return false;
+    }
+    if (src_stride == row_size) {
+        memcpy(upload->src, src, row_size * height);
+    } else {
+        for (GLsizei y = 0; y < height; y++) {
+            memcpy(upload->src + y * row_size, src + y * src_stride, row_size);
+        }
+    }
+    job->src = upload->src;
+    job->src_stride = row_size;
+
+    upload->texture = texture;
+    upload->target = target;
+    upload->level = level;
+    upload->border = border;
+    upload->format = format;
+    upload->type = type;
+    upload->queued = now_ms();
+    upload->task.fn = convert_upload;
+    upload->task.arg = upload;
+    if (convert || step > 1) {
+        pool_submit(&upload->task);
+    } else {
+        upload->pixels = upload->src;
+        upload->src = NULL;
+        upload->task.done = true;
+    }
+
+    texture_upload_t **tail = &uploads;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = upload;
+    texture->pending++;
+    queued_uploads++;
+    if (texture_stats()) {
+        printf("libGL: texture %u: queued level %d, %u uploads pending\n",
+               texture->texture, level, queued_uploads);
+    }
+    return true;
+}
+
+static void unlink_upload(texture_upload_t **prev) {
+    texture_upload_t *upload = *prev;
+    *prev = upload->next;
+    upload->texture->pending--;
+    queued_uploads--;
+    pool_wait(&upload->task);
+}
+
+static void finish_upload(texture_upload_t *upload) {
+    strip_job_t *job = &upload->job;
+    if (upload->pixels) {
+        LOAD_GLES(glPixelStorei);
+        LOAD_GLES(glTexImage2D);
+        bool realign = job->dst_stride % state.texture.unpack_alignment != 0;
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        }
+        gles_glTexImage2D(upload->target, upload->level, upload->format,
+                          job->width, job->rows, upload->border,
+                          upload->format, upload->type, upload->pixels);
+        budget_image(upload->texture, upload->level, job->width, job->rows,
+                     upload->format, upload->type, upload->pixels, 1);
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, state.texture.unpack_alignment);
+        }
+    }
+    if (texture_stats()) {
+        printf("libGL: texture %u: uploaded level %d %.2f ms after queueing, %u uploads pending\n",
+               upload->texture->texture, upload->level, now_ms() - upload->queued, queued_uploads);
+    }
+    free(upload->pixels);
+    free(upload);
+}
+
+// uploads everything queued for a texture, on the GLES texture unit `unit`
+static void flush_texture(gltexture_t *texture, GLuint unit) {
+    if (! texture || ! texture->pending) {
+        return;
+    }
+    gltexture_t *bound = state.texture.bound[unit];
+    LOAD_GLES(glBindTexture);
+    if (texture != bound) {
+        gles_glBindTexture(GL_TEXTURE_2D, texture->texture);
+    }
+    texture_upload_t **prev = &uploads;
+    while (*prev) {
+        texture_upload_t *upload = *prev;
+        if (upload->texture == texture) {
+            unlink_upload(prev);
+            finish_upload(upload);
+        } else {
+            prev = &upload->next;
+        }
+    }
+    if (texture != bound) {
+        gles_glBindTexture(GL_TEXTURE_2D, bound ? bound->texture : 0);
+    }
+}
+
+// a texture is going away, nothing queued for it needs uploading
+static void drop_uploads(gltexture_t *texture) {
+    texture_upload_t **prev = &uploads;
+    while (texture->pending && *prev) {
+        texture_upload_t *upload = *prev;
+        if (upload->texture == texture) {
+            unlink_upload(prev);
+            free(upload->pixels);
+            free(upload);
+        } else {
+            prev = &upload->next;
+        }
+    }
+}
+
+// uploads the textures about to be drawn with
+void gl_texture_flush() {
+    if (! queued_uploads) {
+        return;
+    }
+    GLuint active = state.texture.active;
+    LOAD_GLES(glActiveTexture);
+    for (int i = 0; i < MAX_TEX; i++) {
+        gltexture_t *bound = state.texture.bound[i];
+        if (state.enable.texture_2d[i] && bound && bound->pending) {
+            if (i != active) {
+                gles_glActiveTexture(GL_TEXTURE0 + i);
+            }
+            flush_texture(bound, i);
+            if (i != active) {
+                gles_glActiveTexture(GL_TEXTURE0 + active);
+            }
+        }
+    }
+}
+
+static void flush_all_textures() {
+    while (uploads) {
+        flush_texture(uploads->texture, state.texture.active);
+    }
+}
+
+/*
+LIBGL_ETC1 textures are picked at level 0, for opaque data with 8 bit
+channels, and their other levels follow. The ETC1 data is kept so a sub
+image can decompress the texture back to RGB, as GLES can't update ETC1.
+*/
+
+struct texture_etc1 {
+    GLubyte *levels[MAX_TEXTURE_LEVELS];
+    GLsizei width[MAX_TEXTURE_LEVELS], height[MAX_TEXTURE_LEVELS];
+};
+
+static void drop_etc1(gltexture_t *texture) {
+    struct texture_etc1 *etc1 = texture->etc1;
+    if (etc1) {
+        for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+            free(etc1->levels[i]);
+        }
+        free(etc1);
+        texture->etc1 = NULL;
+    }
+}
+
+// converts a whole level to RGB, shrinking it by step, then encodes and uploads it
+static bool upload_etc1(gltexture_t *texture, GLenum target, GLint level,
+                        GLsizei width, GLsizei height, GLint border,
+                        GLenum src_format, GLenum src_type,
+                        const GLvoid *data, GLsizei step) {
+    pixel_converter_t conv;
+    if (level < 0 || level >= MAX_TEXTURE_LEVELS ||
+        ! pixel_converter(&conv, src_format, src_type, GL_RGB, GL_UNSIGNED_BYTE)) {
+        return false;
+    }
+    strip_job_t job = {
+        .conv = &conv,
+        .step = step,
+        .width = width / step,
+        .rows = height / step,
+    };
+    job.dst_stride = job.width * 3;
+    job.gather_size = step > 1 ? job.width * conv.src_size : 0;
+    int bands = 1;
+    if (job.dst_stride * job.rows >= TEXTURE_THREAD_SIZE) {
+        bands = pool_threads();
+    }
+    if (bands > job.rows) {
+        bands = job.rows;
+    }
+    GLsizei size = etc1_size(job.width, job.rows);
+    GLubyte *rgb = malloc(job.dst_stride * job.rows + job.gather_size * bands);
+    GLubyte *encoded = malloc(size);
+    struct texture_etc1 *etc1 = texture->etc1;
+    if (! etc1) {
+        etc1 = texture->etc1 = calloc(1, sizeof(struct texture_etc1));
+    }
+    if (! rgb || ! encoded || ! etc1) {
+        free(rgb);
+        free(encoded);
+        return false;
+    }
+    double start = texture_stats() ? now_ms() : 0;
+    if (data) {
+        job.src = unpack_rows(data, width, conv.src_size, &job.src_stride);
+        job.dst = rgb;
+        job.gather = rgb + job.dst_stride * job.rows;
+        pool_run(convert_band, &job, bands);
+    } else {
+        memset(rgb, 0, job.dst_stride * job.rows);
+    }
+    etc1_encode(rgb, job.width, job.rows, encoded);
+    free(rgb);
+
+    LOAD_GLES(glCompressedTexImage2D);
+    gles_glCompressedTexImage2D(target, level, GL_ETC1_RGB8_OES, job.width, job.rows,
+                                border, size, encoded);
+    budget_compressed_image(texture, level, job.width, job.rows, GL_ETC1_RGB8_OES, size, encoded);
+    free(etc1->levels[level]);
+    etc1->levels[level] = encoded;
+    etc1->width[level] = job.width;
+    etc1->height[level] = job.rows;
+    if (texture_stats()) {
+        printf("libGL: texture %u: level %d as ETC1 in %.2f ms, %u KB instead of %u KB\n",
+               texture->texture, level, now_ms() - start, size / 1024,
+               job.dst_stride * job.rows / 1024);
+    }
+    return true;
+}
+
+// sends every ETC1 level back to GLES as RGB, for good
+static void decompress_etc1(gltexture_t *texture, GLenum target) {
+    struct texture_etc1 *etc1 = texture->etc1;
+    LOAD_GLES(glPixelStorei);
+    LOAD_GLES(glTexImage2D);
+    for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+        if (! etc1->levels[i]) {
+            continue;
+        }
+        GLsizei width = etc1->width[i], height = etc1->height[i];
+        GLubyte *rgb = scratch_strip(width * height * 3);
+        if (! rgb) {
+            break;
+        }
+        etc1_decode(etc1->levels[i], width, height, rgb);
+        bool realign = (width * 3) % state.texture.unpack_alignment != 0;
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        }
+        gles_glTexImage2D(target, i, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, state.texture.unpack_alignment);
+        }
+        budget_image(texture, i, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb, 1);
+    }
+    drop_etc1(texture);
+}
+
+/*
+Re-specifies every level of a texture in its wide format, once a sub image
+brings alpha that alpha analysis left out, or graded alpha to a 5_5_5_1
+texture. GLES can't read textures back, so a level's old pixels come from
+its ETC1 encoding or the LIBGL_TEXTURE_BUDGET copy, unless the sub image
+replaces all of it. Without them the texture stays as it is.
+*/
+static void widen_texture(gltexture_t *texture, GLenum target, GLint level,
+                          GLint xoffset, GLint yoffset, GLsizei width, GLsizei height) {
+    struct texture_etc1 *etc1 = texture->etc1;
+    GLenum format = texture->wide_format, type = texture->wide_type;
+    GLsizei step = texture->shrink ? texture->shrink : 1;
+    GLsizei w, h;
+    texture->keep_alpha = true;
+    bool replaced[MAX_TEXTURE_LEVELS] = {0};
+    for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+        if (! budget_level(texture, i, &w, &h)) {
+            continue;
+        }
+        replaced[i] = i == level && xoffset == 0 && yoffset == 0 &&
+                      width / step >= w && height / step >= h;
+        if (! replaced[i] && ! (etc1 && etc1->levels[i]) && ! budget_pixels(texture, i)) {
+            if (texture_stats()) {
+                printf("libGL: texture %u: no copy of level %d, alpha is lost\n",
+                       texture->texture, i);
             }
+            texture->wide_format = texture->wide_type = 0;
+            return;
+        }
+    }
+
+    LOAD_GLES(glPixelStorei);
+    LOAD_GLES(glTexImage2D);
+    for (int i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+        if (! budget_level(texture, i, &w, &h)) {
+            continue;
         }
+        GLvoid *pixels = NULL;
+        if (! replaced[i]) {
+            const GLvoid *old = NULL;
+            GLenum old_format = texture->format, old_type = texture->type;
+            if (etc1 && etc1->levels[i]) {
+                GLubyte *rgb = scratch_strip(w * h * 3);
+                if (rgb) {
+                    etc1_decode(etc1->levels[i], w, h, rgb);
+                    old = rgb;
+                }
+                old_format = GL_RGB;
+                old_type = GL_UNSIGNED_BYTE;
+            } else {
+                old = budget_pixels(texture, i);
+            }
+            if (old) {
+                pixel_convert(old, &pixels, w, h, old_format, old_type, format, type);
+            }
+        }
+        bool realign = (w * gl_pixel_sizeof(format, type)) % state.texture.unpack_alignment != 0;
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        }
+        gles_glTexImage2D(target, i, format, w, h, 0, format, type, pixels);
+        if (realign) {
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, state.texture.unpack_alignment);
+        }
+        budget_image(texture, i, w, h, format, type, pixels, 1);
+        free(pixels);
+    }
+    drop_etc1(texture);
+    texture->format = format;
+    texture->type = type;
+    texture->wide_format = texture->wide_type = 0;
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat,
+                  GLsizei width, GLsizei height, GLint border,
+                  GLenum format, GLenum type, const GLvoid *data) {
 
+    ERROR_IN_BLOCK();
+    gltexture_t *bound = state.texture.bound[state.texture.active];
+    GLenum src_format = format, src_type = type;
+    GLenum internal = internal_base(internalFormat);
+    bool convert = texture_format(bound, level == 0, internal, width, height, data,
+                                  &src_format, src_type, &format, &type);
+    bool async = data && bound && async_textures();
+    if (data) {
         char *env_dump = getenv("LIBGL_TEXDUMP");
         if (env_dump && strcmp(env_dump, "1") == 0) {
-            if (bound) {
-                pixel_to_ppm(pixels, width, height, format, type, bound->texture);
+            if (bound && unpack_default(width)) {
+                pixel_to_ppm(data, width, height, src_format, src_type, bound->texture);
             }
         }
-    } else {
-        // convert format even if data is NULL
-        swizzle_texture(width, height, &format, &type, NULL);
     }
+    // later levels keep the base level's step
+    GLsizei step = (level && bound && bound->shrink) ? bound->shrink : shrink_step(width, height);
+    GLsizei src_width = width, src_height = height;
+    step = clamp_step(step, width, height);
+    width /= step;
+    height /= step;
 
     /* TODO:
     GL_INVALID_VALUE is generated if border is not 0.
@@ -156,33 +1054,58 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat,
     */
 
     LOAD_GLES(glTexImage2D);
-    LOAD_GLES(glTexSubImage2D);
 
     switch (target) {
         case GL_PROXY_TEXTURE_2D:
             break;
         default: {
-            GLsizei nheight = npot(height), nwidth = npot(width);
+            bool compress = false;
             if (bound && level == 0) {
+                compress = data && etc1_enabled() && format == GL_RGB &&
+                           pixel_byte_channels(src_type);
+                if (compress) {
+                    type = GL_UNSIGNED_BYTE;
+                } else {
+                    drop_etc1(bound);
+                }
                 bound->width = width;
                 bound->height = height;
-                bound->nwidth = nwidth;
-                bound->nheight = nheight;
+                bound->nwidth = npot(width);
+                bound->nheight = npot(height);
+                bound->internal = internal;
+                bound->format = format;
+                bound->type = type;
+                bound->shrink = step;
+            } else if (bound) {
+                compress = bound->etc1 != NULL;
             }
-            if (false && (height != nheight || width != nwidth)) {
-                gles_glTexImage2D(target, level, format, nwidth, nheight, border,
-                                  format, type, NULL);
-                gles_glTexSubImage2D(target, level, 0, 0, width, height,
-                                     format, type, pixels);
+            if (compress) {
+                flush_texture(bound, state.texture.active);
+                if (upload_etc1(bound, target, level, src_width, src_height, border,
+                                src_format, src_type, data, step)) {
+                    break;
+                }
+            }
+            if (async && queue_upload(bound, target, level, src_width, src_height, border,
+                                      src_format, src_type, format, type, data, convert, step)) {
+                break;
+            }
+            // anything still queued has to land first
+            flush_texture(bound, state.texture.active);
+            if (! data || (! convert && step == 1 && unpack_default(width))) {
+                gles_glTexImage2D(target, level, format, width, height, border,
+                                  format, type, data);
+                budget_image(bound, level, width, height, format, type,
+                             data, state.texture.unpack_alignment);
             } else {
                 gles_glTexImage2D(target, level, format, width, height, border,
-                                  format, type, pixels);
+                                  format, type, NULL);
+                budget_image(bound, level, width, height, format, type, NULL, 1);
+                upload_rows(target, level, 0, 0, src_width, src_height,
+                            src_format, src_type, format, type, data, step);
             }
         }
     }
-    if (pixels != data) {
-        free(pixels);
-    }
 }
 
 void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
@@ -191,11 +1114,81 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
     LOAD_GLES(glTexSubImage2D);
     ERROR_IN_BLOCK();
     target = map_tex_target(target);
-    const GLvoid *pixels = swizzle_texture(width, height, &format, &type, data);
-    gles_glTexSubImage2D(target, level, xoffset, yoffset,
-                         width, height, format, type, pixels);
-    if (pixels != data)
-        free((GLvoid *)pixels);
+    gltexture_t *bound = state.texture.bound[state.texture.active];
+    flush_texture(bound, state.texture.active);
+    if (bound && bound->wide_format && data) {
+        alpha_t alpha = sub_alpha(width, height, format, type, data);
+        if (alpha == ALPHA_GRADED ||
+            (alpha == ALPHA_BINARY && bound->type != GL_UNSIGNED_SHORT_5_5_5_1)) {
+            widen_texture(bound, target, level, xoffset, yoffset, width, height);
+        }
+    }
+    if (bound && bound->etc1) {
+        decompress_etc1(bound, target);
+    }
+    GLenum src_format = format, src_type = type;
+    bool convert = texture_format(bound, false, GL_RGBA, width, height, data,
+                                  &src_format, src_type, &format, &type);
+    GLsizei step = bound && bound->shrink ? bound->shrink : 1;
+    if (step > 1) {
+        // the level was stored shrunk
+        upload_rows(target, level, xoffset / step, yoffset / step, width, height,
+                    src_format, src_type, format, type, data, step);
+    } else if (! convert && unpack_default(width)) {
+        gles_glTexSubImage2D(target, level, xoffset, yoffset,
+                             width, height, format, type, data);
+        budget_sub_image(bound, level, xoffset, yoffset, width, height,
+                         format, type, data, state.texture.unpack_alignment);
+    } else {
+        upload_rows(target, level, xoffset, yoffset, width, height,
+                    src_format, src_type, format, type, data, 1);
+    }
+}
+
+// the budget's copy can't follow pixels that come from the framebuffer
+void glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat,
+                      GLint x, GLint y, GLsizei width, GLsizei height, GLint border) {
+    PUSH_IF_COMPILING(glCopyTexImage2D);
+    LOAD_GLES(glCopyTexImage2D);
+    gltexture_t *bound = state.texture.bound[state.texture.active];
+    flush_texture(bound, state.texture.active);
+    GLenum base = internal_base(internalformat);
+    if (bound && level == 0) {
+        // the framebuffer is copied as it is, at full size
+        bound->width = width;
+        bound->height = height;
+        bound->nwidth = npot(width);
+        bound->nheight = npot(height);
+        bound->internal = base;
+        bound->format = base;
+        bound->type = GL_UNSIGNED_BYTE;
+        bound->shrink = 1;
+        bound->wide_format = bound->wide_type = 0;
+    }
+    if (bound && bound->etc1) {
+        // a new base level replaces the encoding, other levels have to match it
+        if (level == 0) {
+            drop_etc1(bound);
+        } else {
+            decompress_etc1(bound, target);
+        }
+    }
+    budget_image(bound, level, width, height, base, GL_UNSIGNED_BYTE, NULL, 1);
+    budget_pin(bound);
+    gles_glCopyTexImage2D(target, level, internalformat, x, y, width, height, border);
+}
+
+void glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+                         GLint x, GLint y, GLsizei width, GLsizei height) {
+    PUSH_IF_COMPILING(glCopyTexSubImage2D);
+    LOAD_GLES(glCopyTexSubImage2D);
+    gltexture_t *bound = state.texture.bound[state.texture.active];
+    flush_texture(bound, state.texture.active);
+    if (bound && bound->etc1) {
+        decompress_etc1(bound, target);
+    }
+    budget_pin(bound);
+    gles_glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
 }
 
 // 1d stubs
@@ -245,6 +1238,16 @@ void glPixelStorei(GLenum pname, GLint param) {
         case GL_UNPACK_LSB_FIRST:
             state.texture.unpack_lsb_first = param;
             break;
+        case GL_UNPACK_ALIGNMENT:
+            switch (param) {
+                case 1: case 2: case 4: case 8:
+                    break;
+                default:
+                    ERROR(GL_INVALID_VALUE);
+            }
+            state.texture.unpack_alignment = param;
+            gles_glPixelStorei(pname, param);
+            break;
         default:
             gles_glPixelStorei(pname, param);
             break;
@@ -276,6 +1279,16 @@ void glBindTexture(GLenum target, GLuint texture) {
             tex->width = 0;
             tex->height = 0;
             tex->uploaded = false;
+            tex->pending = 0;
+            tex->internal = tex->format = tex->type = 0;
+            tex->shrink = 0;
+            tex->size = tex->used = 0;
+            tex->priority = 1;
+            tex->resident = true;
+            tex->backing = NULL;
+            tex->etc1 = NULL;
+            tex->wide_format = tex->wide_type = 0;
+            tex->keep_alpha = false;
         } else {
             tex = kh_value(list, k);
         }
@@ -289,6 +1302,9 @@ void glBindTexture(GLenum target, GLuint texture) {
 
     LOAD_GLES(glBindTexture);
     gles_glBindTexture(target, texture);
+    if (state.texture.bound[active]) {
+        budget_use(state.texture.bound[active]);
+    }
 }
 
 void glActiveTexture(GLenum texture) {
@@ -355,6 +1371,9 @@ void glDeleteTextures(GLsizei n, const GLuint *textures) {
                     if (tex == state.texture.bound[j])
                         state.texture.bound[j] = NULL;
                 }
+                drop_uploads(tex);
+                budget_delete(tex);
+                drop_etc1(tex);
                 free(tex);
                 kh_del(tex, list, k);
             }
@@ -364,16 +1383,41 @@ void glDeleteTextures(GLsizei n, const GLuint *textures) {
     gles_glDeleteTextures(n, textures);
 }
 
+// looks up a texture name, NULL if it was never bound
+static gltexture_t *find_texture(GLuint texture) {
+    khash_t(tex) *list = state.texture.list;
+    if (! list || ! texture) {
+        return NULL;
+    }
+    khint_t k = kh_get(tex, list, texture);
+    return (k != kh_end(list)) ? kh_value(list, k) : NULL;
+}
+
 GLboolean glAreTexturesResident(GLsizei n, const GLuint *textures, GLboolean *residences) {
     if (state.block.active) {
         gl_set_error(GL_INVALID_OPERATION);
-        return 0;
+        return GL_FALSE;
     }
     if (n < 0) {
         gl_set_error(GL_INVALID_VALUE);
-        return 0;
+        return GL_FALSE;
     }
-    return true;
+    bool all = true;
+    for (int i = 0; i < n; i++) {
+        gltexture_t *tex = find_texture(textures[i]);
+        if (! tex) {
+            gl_set_error(GL_INVALID_VALUE);
+            return GL_FALSE;
+        }
+        all = all && tex->resident;
+    }
+    // residences is only written when something isn't resident
+    if (! all) {
+        for (int i = 0; i < n; i++) {
+            residences[i] = find_texture(textures[i])->resident;
+        }
+    }
+    return all;
 }
 
 void glPrioritizeTextures(GLsizei n, const GLuint *textures, const GLclampf *priorities) {
@@ -381,4 +1425,25 @@ void glPrioritizeTextures(GLsizei n, const GLuint *textures, const GLclampf *pri
     if (n < 0) {
         ERROR(GL_INVALID_VALUE);
     }
+    for (int i = 0; i < n; i++) {
+        gltexture_t *tex = find_texture(textures[i]);
+        if (tex) {
+            GLclampf priority = priorities[i];
+            tex->priority = priority < 0 ? 0 : (priority > 1 ? 1 : priority);
+        }
+    }
+}
+
+// sync points, everything queued has to be on the GLES side first
+void glFinish() {
+    LOAD_GLES(glFinish);
+    flush_all_textures();
+    gles_glFinish();
+}
+
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+                  GLenum format, GLenum type, GLvoid *data) {
+    LOAD_GLES(glReadPixels);
+    flush_all_textures();
+    gles_glReadPixels(x, y, width, height, format, type, data);
 }
@@ -26,6 +26,7 @@ void tex_coord_npot(GLfloat *tex, GLsizei len,
                     GLsizei width, GLsizei height,
                     GLsizei nwidth, GLsizei nheight);
 int npot(int n);
+void gl_texture_flush();
 
 static inline GLenum map_tex_target(GLenum target) {
     switch (target) {
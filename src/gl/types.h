@@ -16,6 +16,8 @@
 typedef struct {
     uint32_t len;
     uint32_t cap;
+    // number of vertices, as len counts indices once a block has them
+    uint32_t vert_len;
     GLenum mode;
     struct {
         GLfloat tex[MAX_TEX][2];
@@ -32,6 +34,10 @@ typedef struct {
     GLfloat *normal;
     GLfloat *color;
     GLfloat *tex[MAX_TEX];
+    // glTexGen output, kept so display list blocks reuse it every draw,
+    // and what it was generated from
+    GLfloat *texgen[MAX_TEX];
+    struct texgen_key *texgen_key[MAX_TEX];
     GLushort *indices;
     GLboolean q2t;
 
@@ -41,6 +47,9 @@ typedef struct {
 
     GLboolean open;
     GLboolean artificial;
+    // vert/normal/color belong to the glLockArraysEXT cache and tex already
+    // holds any glTexGen output
+    GLboolean locked;
 } block_t;
 
 typedef struct {
@@ -95,6 +104,24 @@ typedef struct {
     GLsizei nwidth;
     GLsizei nheight;
     GLboolean uploaded;
+    // the base internal format, and what GLES stores it as
+    GLenum internal, format, type;
+    // glTexImage2D calls waiting to be uploaded
+    GLuint pending;
+    // what LIBGL_SHRINK and size limits divide each side by
+    GLsizei shrink;
+    // bytes the driver holds for it, and the frame it was last bound in
+    GLuint size, used;
+    GLclampf priority;
+    GLboolean resident;
+    // our copy of its levels, for LIBGL_TEXTURE_BUDGET
+    struct texture_backing *backing;
+    // the levels uploaded as ETC1, NULL unless LIBGL_ETC1 encoded it
+    struct texture_etc1 *etc1;
+    // what to store it as if a sub image brings alpha that alpha analysis
+    // left out, or 0. once that happens, the analysis is skipped for good
+    GLenum wide_format, wide_type;
+    GLboolean keep_alpha;
 } gltexture_t;
 
 KHASH_MAP_INIT_INT(tex, gltexture_t *)
@@ -123,6 +150,7 @@ typedef struct {
     GLuint unpack_row_length,
            unpack_skip_pixels,
            unpack_skip_rows;
+    GLint unpack_alignment;
     GLboolean unpack_lsb_first;
     // TODO: do we only need to worry about GL_TEXTURE_2D?
     GLboolean rect_arb[MAX_TEX];
@@ -133,11 +161,42 @@ typedef struct {
     GLuint client;
 } texture_state_t;
 
+// buffer.c
+typedef struct {
+    GLuint buffer;
+    GLenum usage;
+    GLsizeiptr size;
+    // CPU copy for the paths that read vertex data themselves, or NULL
+    GLvoid *shadow;
+    // one of those paths found no shadow, so keep one from the next upload on
+    GLboolean want_shadow;
+    GLboolean mapped;
+    GLenum access;
+} glbuffer_t;
+
+KHASH_MAP_INIT_INT(buffer, glbuffer_t *)
+
+typedef struct {
+    khash_t(buffer) *list;
+    // what the app has bound
+    glbuffer_t *array, *element;
+    // what GLES has bound, which differs while we draw from our own memory
+    GLuint gles_array, gles_element;
+} buffer_state_t;
+
+// converts one array element to floats, padded out to 4 like GL does
+typedef void (*gl_fetch_t)(const GLvoid *src, GLfloat *out);
+
 typedef struct {
     GLint size;
     GLenum type;
     GLsizei stride;
     const GLvoid *pointer;
+    // pointer is an offset into this buffer if set
+    glbuffer_t *buffer;
+    // worked out when the pointer is set, for glArrayElement
+    GLsizei real_stride;
+    gl_fetch_t fetch;
 } pointer_state_t;
 
 typedef struct {
@@ -159,9 +218,38 @@ typedef struct {
     GLenum mode;
 } displaylist_state_t;
 
+// what glTexGen output depends on, so cached coords can be checked cheaply
+typedef struct texgen_key {
+    texgen_state_t texgen;
+    GLboolean s, t;
+    // the current normal and texcoord, when the block has none
+    GLfloat normal[3], tex[2];
+    // only set for the eye space modes. the version is checked first, the
+    // matrix only when it moved, as apps often reload the same camera
+    GLuint modelview_version;
+    simd4x4f modelview;
+} texgen_key_t;
+
+// glLockArraysEXT range, converted by the first draw that needs it
+typedef struct {
+    GLint first;
+    GLsizei count;
+    // what each array was converted from, so a moved pointer gets redone
+    pointer_states_t pointers;
+    GLfloat *vert, *normal, *color, *tex[MAX_TEX];
+    // bumped when vert or normal are reconverted
+    GLuint version;
+    struct {
+        GLfloat *coords;
+        texgen_key_t key;
+        GLuint version;
+    } texgen[MAX_TEX];
+} locked_arrays_t;
+
 typedef struct {
     block_t *active;
     GLboolean locked;
+    locked_arrays_t arrays;
 } block_state_t;
 
 typedef struct {
@@ -179,13 +267,24 @@ typedef struct {
 // matrix structs
 typedef struct {
     simd4x4f matrix;
-    tack_t stack;
+    // pushed matrices, the current one isn't stored here
+    simd4x4f *stack;
+    uint32_t depth, cap;
+    // bumped on every change
+    GLuint version;
     bool init;
+    // bottom row is 0 0 0 1, so transformed points keep w = 1
+    bool affine;
+    // changed since it was last uploaded
+    bool dirty;
 } matrix_state_t;
 
 typedef struct {
     GLenum mode;
     matrix_state_t model, projection, texture[MAX_TEX], color;
+    // the mode GLES is in, and whether any matrix is waiting for upload
+    GLenum gles_mode;
+    bool dirty;
 } matrix_states_t;
 
 typedef struct {
@@ -233,6 +332,7 @@ typedef struct {
 
     GLenum error;
     block_state_t block;
+    buffer_state_t buffers;
     current_state_t current;
     enable_state_t enable;
     feedback_state_t feedback;
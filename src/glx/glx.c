@@ -9,8 +9,10 @@
 
 #include "glx.h"
 
+#include "../gl/budget.h"
 #include "../gl/loader.h"
 #include "../gl/raster.h"
+#include "../gl/stream.h"
 #include "../gl/text.h"
 #include "liveinfo.h"
 
@@ -429,6 +431,8 @@ Bool glXMakeContextCurrent(Display *dpy, GLXDrawable draw, int read, GLXContext
 
 void glXSwapBuffers(Display *dpy, GLXDrawable drawable) {
     static int frames = 0;
+    stream_frame();
+    budget_frame();
     if (g_showfps || g_liveinfo) {
         // framerate counter
         static float avg, fps = 0;
@@ -455,6 +459,12 @@ void glXSwapBuffers(Display *dpy, GLXDrawable drawable) {
                 avg = frame / (float)(now - frame1);
                 if (g_showfps) {
                     printf("libGL fps: %.2f, avg: %.2f\n", fps, avg);
+                    if (stream_enabled()) {
+                        stream_stats_t stats;
+                        stream_stats(&stats);
+                        printf("libGL stream: %u KB, %u uploads, %u wraps last frame\n",
+                               stats.bytes / 1024, stats.uploads, stats.wraps);
+                    }
                 }
             }
         }
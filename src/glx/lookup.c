@@ -1,6 +1,7 @@
 #include <GL/gl.h>
 
 #include "glx.h"
+#include "../gl/buffer.h"
 #include "../gl/loader.h"
 #include "../gl/wrap/extra.h"
 
@@ -65,22 +66,24 @@ void *glXGetProcAddressARB(const GLubyte *name) {
     EX(glXWaitGL);
     EX(glXWaitX);
 
+#ifndef USE_ES2
     // GL_ARB_vertex_buffer_object
-/*
     ARB(glBindBuffer);
     ARB(glBufferData);
     ARB(glBufferSubData);
     ARB(glDeleteBuffers);
     ARB(glGenBuffers);
+    ARB(glGetBufferParameteriv);
     ARB(glIsBuffer);
-    MAP_EGL(glGetBufferParameteriARB, glGetBufferParameteriOES);
-    MAP_EGL(glGetBufferPointerARB, glGetBufferPointerOES);
-    MAP_EGL(glGetBufferPointervARB, glGetBufferPointervOES);
-    MAP_EGL(glMapBufferARB, glMapBufferOES);
-    MAP_EGL(glUnmapBufferARB, glMapBufferOES);
-    STUB(glGetBufferParameterivARB);
-    STUB(glGetBufferSubDataARB);
-*/
+    EX(glGetBufferPointerv);
+    ARB(glGetBufferPointerv);
+    EX(glGetBufferSubData);
+    ARB(glGetBufferSubData);
+    EX(glMapBuffer);
+    ARB(glMapBuffer);
+    EX(glUnmapBuffer);
+    ARB(glUnmapBuffer);
+#endif
 
     // OES wrapper
     EX(glClearDepthfOES);
@@ -170,6 +173,8 @@ void *glXGetProcAddressARB(const GLubyte *name) {
     EX(glDisable);
     EX(glDrawBuffer);
     EX(glDrawPixels);
+    EX(glDrawRangeElements);
+    MAP("glDrawRangeElementsEXT", glDrawRangeElements);
     EX(glEdgeFlag);
     EX(glEnable);
     EX(glEnd);
@@ -221,6 +226,10 @@ void *glXGetProcAddressARB(const GLubyte *name) {
     EX(glMapGrid2d);
     EX(glMapGrid2f);
     EX(glMateriali);
+    EX(glMultiDrawArrays);
+    MAP("glMultiDrawArraysEXT", glMultiDrawArrays);
+    EX(glMultiDrawElements);
+    MAP("glMultiDrawElementsEXT", glMultiDrawElements);
     EX(glMultiTexCoord2f);
     EX(glMultiTexCoord2fARB);
     EX(glMultiTexCoord2fv);
@@ -29,6 +29,7 @@ static const GLsizei gl_sizeof(GLenum type) {
     switch (type) {
         case GL_DOUBLE:
             return 8;
+        case GL_FIXED:
         case GL_FLOAT:
         case GL_INT:
         case GL_UNSIGNED_INT:
@@ -41,6 +42,7 @@ static const GLsizei gl_sizeof(GLenum type) {
         case GL_3_BYTES:
             return 3;
         case GL_LUMINANCE_ALPHA:
+        case GL_SHORT:
         case GL_UNSIGNED_SHORT:
         case GL_UNSIGNED_SHORT_1_5_5_5_REV:
         case GL_UNSIGNED_SHORT_4_4_4_4:
@@ -50,6 +52,7 @@ static const GLsizei gl_sizeof(GLenum type) {
         case GL_UNSIGNED_SHORT_5_6_5_REV:
         case GL_2_BYTES:
             return 2;
+        case GL_BYTE:
         case GL_LUMINANCE:
         case GL_UNSIGNED_BYTE:
         case GL_UNSIGNED_BYTE_2_3_3_REV:
@@ -103,6 +106,7 @@ static const GLsizei gl_pixel_sizeof(GLenum format, GLenum type) {
     GLsizei width = 0;
     switch (format) {
         case GL_ALPHA:
+        case GL_INTENSITY:
         case GL_LUMINANCE:
         case GL_RED:
             width = 1;
@@ -142,6 +146,17 @@ static inline const bool gl_valid_vertex_type(GLenum type) {
     }
 }
 
+static inline const bool gl_valid_color_type(GLenum type) {
+    switch (type) {
+        case GL_FIXED:
+        case GL_FLOAT:
+        case GL_UNSIGNED_BYTE:
+            return true;
+        default:
+            return false;
+    }
+}
+
 static inline const bool gl_valid_mode(GLenum mode) {
     switch (mode) {
         case GL_POINTS:
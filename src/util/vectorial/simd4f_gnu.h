@@ -63,6 +63,25 @@ vectorial_inline void simd4f_ustore2(const simd4f val, float *ary) {
     memcpy(ary, &val, sizeof(float) * 2);
 }
 
+// four packed xyz triples to and from one vector per component
+vectorial_inline void simd4f_uload3x4(const float *ary, simd4f *x, simd4f *y, simd4f *z) {
+    simd4f sx = { ary[0], ary[3], ary[6], ary[9] };
+    simd4f sy = { ary[1], ary[4], ary[7], ary[10] };
+    simd4f sz = { ary[2], ary[5], ary[8], ary[11] };
+    *x = sx;
+    *y = sy;
+    *z = sz;
+}
+
+vectorial_inline void simd4f_ustore3x4(const simd4f x, const simd4f y, const simd4f z, float *ary) {
+    _simd4f_union ux = {x}, uy = {y}, uz = {z};
+    for (int i = 0; i < 4; i++) {
+        ary[i * 3 + 0] = ux.f[i];
+        ary[i * 3 + 1] = uy.f[i];
+        ary[i * 3 + 2] = uz.f[i];
+    }
+}
+
 
 vectorial_inline simd4f simd4f_splat(float v) { 
     simd4f s = { v, v, v, v }; 
@@ -66,6 +66,22 @@ vectorial_inline void simd4f_ustore2(const simd4f val, float *ary) {
     vst1_f32( (float32_t*)ary, low);
 }
 
+// four packed xyz triples to and from one vector per component
+vectorial_inline void simd4f_uload3x4(const float *ary, simd4f *x, simd4f *y, simd4f *z) {
+    const float32x4x3_t v = vld3q_f32((const float32_t *)ary);
+    *x = v.val[0];
+    *y = v.val[1];
+    *z = v.val[2];
+}
+
+vectorial_inline void simd4f_ustore3x4(const simd4f x, const simd4f y, const simd4f z, float *ary) {
+    float32x4x3_t v;
+    v.val[0] = x;
+    v.val[1] = y;
+    v.val[2] = z;
+    vst3q_f32((float32_t *)ary, v);
+}
+
 
 
 
@@ -58,6 +58,22 @@ vectorial_inline void simd4f_ustore2(const simd4f val, float *ary) {
     memcpy(ary, &val, sizeof(float) * 2);
 }
 
+// four packed xyz triples to and from one vector per component
+vectorial_inline void simd4f_uload3x4(const float *ary, simd4f *x, simd4f *y, simd4f *z) {
+    *x = simd4f_create(ary[0], ary[3], ary[6], ary[9]);
+    *y = simd4f_create(ary[1], ary[4], ary[7], ary[10]);
+    *z = simd4f_create(ary[2], ary[5], ary[8], ary[11]);
+}
+
+vectorial_inline void simd4f_ustore3x4(const simd4f x, const simd4f y, const simd4f z, float *ary) {
+    const float *fx = &x.x, *fy = &y.x, *fz = &z.x;
+    for (int i = 0; i < 4; i++) {
+        ary[i * 3 + 0] = fx[i];
+        ary[i * 3 + 1] = fy[i];
+        ary[i * 3 + 2] = fz[i];
+    }
+}
+
 
 
 // utilities
@@ -59,6 +59,32 @@ vectorial_inline void simd4f_ustore2(const simd4f val, float *ary) {
     memcpy(ary, &val, sizeof(float) * 2);
 }
 
+// four packed xyz triples to and from one vector per component
+vectorial_inline void simd4f_uload3x4(const float *ary, simd4f *x, simd4f *y, simd4f *z) {
+    const simd4f a = _mm_loadu_ps(ary);     // x0 y0 z0 x1
+    const simd4f b = _mm_loadu_ps(ary + 4); // y1 z1 x2 y2
+    const simd4f c = _mm_loadu_ps(ary + 8); // z2 x3 y3 z3
+    const simd4f xs = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+    const simd4f ys0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+    const simd4f ys1 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+    const simd4f zs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+    *x = _mm_shuffle_ps(a, xs, _MM_SHUFFLE(2, 0, 3, 0));
+    *y = _mm_shuffle_ps(ys0, ys1, _MM_SHUFFLE(2, 0, 2, 0));
+    *z = _mm_shuffle_ps(zs, c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+vectorial_inline void simd4f_ustore3x4(const simd4f x, const simd4f y, const simd4f z, float *ary) {
+    const simd4f xxyy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+    const simd4f zzxx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+    const simd4f yyzz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    const simd4f xxyy2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+    const simd4f zzxx3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+    const simd4f yyzz3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+    _mm_storeu_ps(ary, _mm_shuffle_ps(xxyy, zzxx, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(ary + 4, _mm_shuffle_ps(yyzz, xxyy2, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(ary + 8, _mm_shuffle_ps(zzxx3, yyzz3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
 
 // utilites
 
@@ -298,6 +298,51 @@ vectorial_inline void simd4x4f_axis_rotation(simd4x4f* m, float radians, simd4f
 }
 
 
+/*
+  The _inplace transforms below compute m = m * T for a translation, scaling
+  or rotation T without building T, touching only the columns T changes.
+*/
+
+vectorial_inline void simd4x4f_translate_inplace(simd4x4f* m, float x, float y, float z) {
+    m->w = simd4f_add( simd4f_add( simd4f_mul(m->x, simd4f_splat(x)),
+                                   simd4f_mul(m->y, simd4f_splat(y)) ),
+                       simd4f_add( simd4f_mul(m->z, simd4f_splat(z)), m->w ) );
+}
+
+
+vectorial_inline void simd4x4f_scale_inplace(simd4x4f* m, float x, float y, float z) {
+    m->x = simd4f_mul(m->x, simd4f_splat(x));
+    m->y = simd4f_mul(m->y, simd4f_splat(y));
+    m->z = simd4f_mul(m->z, simd4f_splat(z));
+}
+
+
+vectorial_inline void simd4x4f_rotate_inplace(simd4x4f* m, float radians, simd4f axis) {
+    simd4x4f r;
+    simd4x4f_axis_rotation(&r, radians, axis);
+
+    const simd4f x = m->x;
+    const simd4f y = m->y;
+    const simd4f z = m->z;
+
+    #define rotate_column(c) \
+        simd4f_add( simd4f_add( simd4f_mul(x, simd4f_splat_x(c)), \
+                                simd4f_mul(y, simd4f_splat_y(c)) ), \
+                    simd4f_mul(z, simd4f_splat_z(c)) )
+    m->x = rotate_column(r.x);
+    m->y = rotate_column(r.y);
+    m->z = rotate_column(r.z);
+    #undef rotate_column
+}
+
+
+// true when the bottom row is 0 0 0 1, so w stays 1 for points
+vectorial_inline int simd4x4f_is_affine(const simd4x4f* m) {
+    return simd4f_get_w(m->x) == 0.0f && simd4f_get_w(m->y) == 0.0f &&
+           simd4f_get_w(m->z) == 0.0f && simd4f_get_w(m->w) == 1.0f;
+}
+
+
 
 vectorial_inline void simd4x4f_add(simd4x4f* a, simd4x4f* b, simd4x4f* out) {
     
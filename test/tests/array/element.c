@@ -0,0 +1,59 @@
+int main() {
+    GLshort vert[] = {
+        0, 1,
+        2, 3,
+        4, 5,
+    };
+    GLubyte color[] = {
+        0, 0, 0,
+        255, 0, 255,
+        0, 255, 0,
+    };
+    GLfloat tex[] = {
+        0, 0, 9,
+        1, 0, 9,
+        1, 1, 9,
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_SHORT, 0, vert);
+    glColorPointer(3, GL_UNSIGNED_BYTE, 0, color);
+    glTexCoordPointer(2, GL_FLOAT, 3 * sizeof(GLfloat), tex);
+
+    glBegin(GL_TRIANGLES);
+    glArrayElement(2);
+    glArrayElement(0);
+    glArrayElement(1);
+    glEnd();
+
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glEnableClientState(GL_COLOR_ARRAY);
+    test_glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    test_glVertexPointer(2, GL_SHORT, 0, vert);
+    test_glColorPointer(3, GL_UNSIGNED_BYTE, 0, color);
+    test_glTexCoordPointer(2, GL_FLOAT, 3 * sizeof(GLfloat), tex);
+
+    GLfloat block_vert[] = {
+        4, 5, 0,
+        0, 1, 0,
+        2, 3, 0,
+    };
+    GLfloat block_color[] = {
+        0, 1, 0, 1,
+        0, 0, 0, 1,
+        1, 0, 1, 1,
+    };
+    GLfloat block_tex[] = {
+        1, 1,
+        0, 0,
+        1, 0,
+    };
+    // the last color sticks after glEnd
+    test_glColor4f(1.0, 0.0, 1.0, 1.0);
+    test_glVertexPointer(3, GL_FLOAT, 0, block_vert);
+    test_glColorPointer(4, GL_FLOAT, 0, block_color);
+    test_glTexCoordPointer(2, GL_FLOAT, 0, block_tex);
+    test_glDrawArrays(GL_TRIANGLES, 0, 3);
+    mock_return;
+}
@@ -0,0 +1,40 @@
+static GLfloat vert[70003 * 3];
+
+int main() {
+    GLushort short_indices[] = {0, 1, 2};
+    GLubyte byte_indices[] = {2, 1, 0};
+    GLuint small_indices[] = {1, 2, 3};
+    GLuint large_indices[] = {
+        70000, 70001, 70002,
+        0, 1, 2,
+    };
+    for (int i = 0; i < 70003 * 3; i++) {
+        vert[i] = i / 3;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, short_indices);
+    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_BYTE, byte_indices);
+    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, small_indices);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, large_indices);
+
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    // 8 and 16-bit indices go straight to GLES
+    test_glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, short_indices);
+    test_glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_BYTE, byte_indices);
+
+    // no OES_element_index_uint, so 32-bit indices are narrowed
+    GLushort small_out[] = {1, 2, 3};
+    test_glGetString(GL_EXTENSIONS);
+    test_glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, small_out);
+
+    // and split into windows that 16-bit indices can reach
+    GLushort large_out[] = {0, 1, 2};
+    test_glGetString(GL_EXTENSIONS);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert + 70000 * 3);
+    test_glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, large_out);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, large_out);
+    mock_return;
+}
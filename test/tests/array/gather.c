@@ -0,0 +1,88 @@
+int main() {
+    GLfloat vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+        6, 6, 6,
+        7, 7, 7,
+    };
+    GLubyte color[] = {
+        0, 0, 0, 255,
+        51, 51, 51, 255,
+        0, 255, 0, 255,
+        153, 153, 153, 255,
+        204, 204, 204, 255,
+        255, 255, 255, 255,
+        0, 51, 102, 153,
+        255, 0, 255, 0,
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+
+    // dense indices keep their winding, rebased to the lowest vertex
+    GLubyte quads[] = {4, 5, 6, 7, 5, 6, 7, 4};
+    glDrawElements(GL_QUADS, 8, GL_UNSIGNED_BYTE, quads);
+
+    // sparse indices gather just the vertices they name
+    GLushort sparse[] = {7, 0, 2, 5};
+    glDrawElements(GL_QUADS, 4, GL_UNSIGNED_SHORT, sparse);
+
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glEnableClientState(GL_COLOR_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+
+    GLfloat dense_vert[] = {
+        4, 4, 4,
+        5, 5, 5,
+        6, 6, 6,
+        7, 7, 7,
+    };
+    GLfloat dense_color[] = {
+        0.8, 0.8, 0.8, 1.0,
+        1.0, 1.0, 1.0, 1.0,
+        0.0, 0.2, 0.4, 0.6,
+        1.0, 0.0, 1.0, 0.0,
+    };
+    GLushort dense_indices[] = {
+        0, 1, 3, 1, 2, 3,
+        1, 2, 0, 2, 3, 0,
+    };
+    test_glVertexPointer(3, GL_FLOAT, 0, dense_vert);
+    // normalized with a multiply by 1 / 255, which can be an ulp off dividing
+    glColorPointer_INDEXED *gathered = mock_cur();
+    assert(gathered && gathered->func == glColorPointer_INDEX);
+    assert(gathered->args.a1 == 4 && gathered->args.a2 == GL_FLOAT);
+    for (int i = 0; i < 16; i++) {
+        assert(fabsf(((GLfloat *)gathered->args.a4)[i] - dense_color[i]) < 1e-6);
+    }
+    mock_shift();
+    test_glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, dense_indices);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+
+    GLfloat sparse_vert[] = {
+        7, 7, 7,
+        0, 0, 0,
+        2, 2, 2,
+        5, 5, 5,
+    };
+    GLfloat sparse_color[] = {
+        1.0, 0.0, 1.0, 0.0,
+        0.0, 0.0, 0.0, 1.0,
+        0.0, 1.0, 0.0, 1.0,
+        1.0, 1.0, 1.0, 1.0,
+    };
+    GLushort sparse_indices[] = {0, 1, 3, 1, 2, 3};
+    test_glVertexPointer(3, GL_FLOAT, 0, sparse_vert);
+    test_glColorPointer(4, GL_FLOAT, 0, sparse_color);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, sparse_indices);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+    mock_return;
+}
@@ -0,0 +1,40 @@
+int main() {
+    struct {
+        GLubyte color[4];
+        GLfloat vert[3];
+    } data[] = {
+        {{0, 0, 0, 255}, {0, 0, 0}},
+        {{255, 0, 0, 255}, {1, 1, 1}},
+        {{0, 255, 0, 255}, {2, 2, 2}},
+        {{0, 0, 255, 255}, {3, 3, 3}},
+        {{255, 255, 255, 0}, {4, 4, 4}},
+    };
+    glInterleavedArrays(GL_C4UB_V3F, 0, data);
+
+    // both arrays are converted in one pass over the interleaved vertices
+    GLushort quads[] = {4, 0, 1, 2};
+    glDrawElements(GL_QUADS, 4, GL_UNSIGNED_SHORT, quads);
+
+    test_glEnableClientState(GL_COLOR_ARRAY);
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glColorPointer(4, GL_UNSIGNED_BYTE, 16, data);
+    test_glVertexPointer(3, GL_FLOAT, 16, (GLubyte *)data + 4);
+
+    GLfloat vert[] = {
+        4, 4, 4,
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+    };
+    GLfloat color[] = {
+        1, 1, 1, 0,
+        0, 0, 0, 1,
+        1, 0, 0, 1,
+        0, 1, 0, 1,
+    };
+    GLushort indices[] = {0, 1, 3, 1, 2, 3};
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glColorPointer(4, GL_FLOAT, 0, color);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    mock_return;
+}
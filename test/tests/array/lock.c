@@ -0,0 +1,46 @@
+int main() {
+    GLdouble vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_DOUBLE, 0, vert);
+    glLockArraysEXT(0, 6);
+    glDrawArrays(GL_QUADS, 2, 4);
+
+    // locked arrays are converted once, so this isn't seen until unlocked
+    vert[6] = 9;
+    glDrawArrays(GL_QUADS, 2, 4);
+    glUnlockArraysEXT();
+    glDrawArrays(GL_QUADS, 2, 4);
+
+    GLfloat locked[] = {
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    GLfloat unlocked[] = {
+        9, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    GLushort indices[] = {0, 1, 3, 1, 2, 3};
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_DOUBLE, 0, vert);
+    test_glVertexPointer(3, GL_FLOAT, 0, locked);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    test_glVertexPointer(3, GL_DOUBLE, 0, vert);
+    test_glVertexPointer(3, GL_FLOAT, 0, locked);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    test_glVertexPointer(3, GL_DOUBLE, 0, vert);
+    test_glVertexPointer(3, GL_FLOAT, 0, unlocked);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    test_glVertexPointer(3, GL_DOUBLE, 0, vert);
+    mock_return;
+}
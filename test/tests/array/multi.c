@@ -0,0 +1,43 @@
+int main() {
+    GLfloat vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+        6, 6, 6,
+        7, 7, 7,
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+
+    GLint first[] = {0, 4};
+    GLsizei strips[] = {4, 3};
+    glMultiDrawArrays(GL_TRIANGLE_STRIP, first, strips, 2);
+    GLsizei quads[] = {4, 4};
+    glMultiDrawArrays(GL_QUADS, first, quads, 2);
+
+    GLubyte fan1[] = {0, 1, 2, 3};
+    GLubyte fan2[] = {4, 5, 6};
+    GLvoid *const fans[] = {fan1, fan2};
+    GLsizei fan_count[] = {4, 3};
+    glMultiDrawElements(GL_TRIANGLE_FAN, fan_count, GL_UNSIGNED_BYTE, fans, 2);
+
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+
+    // strips are joined with degenerate triangles
+    GLushort strip[] = {0, 1, 2, 3, 3, 4, 4, 5, 6};
+    test_glDrawElements(GL_TRIANGLE_STRIP, 9, GL_UNSIGNED_SHORT, strip);
+
+    GLushort triangles[] = {
+        0, 1, 3, 1, 2, 3,
+        4, 5, 7, 5, 6, 7,
+    };
+    test_glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, triangles);
+
+    GLushort fan[] = {0, 1, 2, 0, 2, 3, 4, 5, 6};
+    test_glDrawElements(GL_TRIANGLES, 9, GL_UNSIGNED_SHORT, fan);
+    mock_return;
+}
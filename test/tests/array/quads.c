@@ -0,0 +1,63 @@
+int main() {
+    GLfloat vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+        6, 6, 6,
+        7, 7, 7,
+    };
+    GLubyte color[] = {
+        0, 0, 0, 255,
+        1, 1, 1, 255,
+        2, 2, 2, 255,
+        3, 3, 3, 255,
+        4, 4, 4, 255,
+        5, 5, 5, 255,
+        6, 6, 6, 255,
+        7, 7, 7, 255,
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+    glDrawArrays(GL_QUADS, 0, 8);
+    glDrawArrays(GL_QUADS, 2, 5);
+
+    // GLES-compatible arrays are drawn in place with the q2t winding
+    GLushort indices[] = {
+        0, 1, 3, 1, 2, 3,
+        4, 5, 7, 5, 6, 7,
+    };
+    GLushort offset[] = {2, 3, 5, 3, 4, 5};
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glEnableClientState(GL_COLOR_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+    test_glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_SHORT, indices);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, offset);
+
+    // a quad drawn through a block hands GLES back the app's pointers,
+    // so the direct draw after it doesn't read the freed block
+    GLubyte quad[] = {0, 1, 2, 3};
+    glDrawElements(GL_QUADS, 4, GL_UNSIGNED_BYTE, quad);
+    glDrawArrays(GL_QUADS, 0, 4);
+    // the block's arrays are gone by now, so only check they weren't the app's
+    glVertexPointer_INDEXED *block_vert = mock_cur();
+    assert(block_vert && block_vert->func == glVertexPointer_INDEX);
+    assert(block_vert->args.a4 != vert);
+    mock_shift();
+    glColorPointer_INDEXED *block_color = mock_cur();
+    assert(block_color && block_color->func == glColorPointer_INDEX);
+    assert(block_color->args.a4 != color);
+    mock_shift();
+    glDrawElements_INDEXED *block_draw = mock_cur();
+    assert(block_draw && block_draw->func == glDrawElements_INDEX);
+    mock_shift();
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glColorPointer(4, GL_UNSIGNED_BYTE, 0, color);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    mock_return;
+}
@@ -0,0 +1,48 @@
+#include "buffer.h"
+
+int main() {
+    // array buffers are only shadowed once they're read
+    setenv("LIBGL_VBO_SHADOW", "0", 1);
+    GLdouble vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    glBindBuffer(GL_ARRAY_BUFFER, 1);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_STREAM_DRAW);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_DOUBLE, 0, NULL);
+    // the buffer has no shadow yet, so GLES draws it as it is
+    glDrawArrays(GL_QUADS, 2, 4);
+    // and can't be mapped, there's nothing to map it from
+    assert(glMapBuffer(GL_ARRAY_BUFFER, GL_READ_WRITE) == NULL);
+    assert(glGetError() == GL_INVALID_OPERATION);
+
+    // but it keeps one from the next upload on, and GL_DOUBLE is converted
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_STREAM_DRAW);
+    glDrawArrays(GL_QUADS, 2, 4);
+
+    GLushort quads[] = {2, 3, 5, 3, 4, 5};
+    GLushort indices[] = {0, 1, 3, 1, 2, 3};
+    GLfloat converted[] = {
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    test_glBindBuffer(GL_ARRAY_BUFFER, 1);
+    test_glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_DYNAMIC_DRAW);
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_DOUBLE, 0, NULL);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, quads);
+
+    test_glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_DYNAMIC_DRAW);
+    test_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    test_glVertexPointer(3, GL_FLOAT, 0, converted);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    test_glBindBuffer(GL_ARRAY_BUFFER, 1);
+    mock_return;
+}
@@ -1,6 +1,7 @@
 int main() {
 #define STRIDE 0, 0, 0, 0, 0, 0, 0, 0, 0
-    GLfloat vert[] = {
+    // GL_DOUBLE isn't a GLES vertex type, so this goes through the copy path
+    GLdouble vert[] = {
         0, 0, 0, STRIDE,
         1, 1, 1, STRIDE,
         2, 2, 2, STRIDE,
@@ -9,7 +10,7 @@ int main() {
         5, 5, 5, STRIDE,
     };
     glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 12 * 4, vert);
+    glVertexPointer(3, GL_DOUBLE, 12 * 8, vert);
     glDrawArrays(GL_QUADS, 2, 4);
 
     GLfloat vert_out[] = {
@@ -20,7 +21,7 @@ int main() {
     };
     GLushort indices[] = {0, 1, 3, 1, 2, 3};
     test_glEnableClientState(GL_VERTEX_ARRAY);
-    test_glVertexPointer(3, GL_FLOAT, 12 * 4, vert);
+    test_glVertexPointer(3, GL_DOUBLE, 12 * 8, vert);
     test_glVertexPointer(3, GL_FLOAT, 0, vert_out);
     test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
     mock_return;
@@ -0,0 +1,81 @@
+#include "stream.h"
+
+#define BIG 2340
+
+static GLfloat big_vert[BIG * 3], big_color[BIG * 4];
+
+int main() {
+    setenv("LIBGL_STREAM", "1", 1);
+    setenv("LIBGL_STREAM_SIZE", "64", 1);
+
+    GLfloat vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glDrawArrays(GL_TRIANGLES, 1, 3);
+    stream_frame();
+
+    stream_stats_t stats;
+    stream_stats(&stats);
+    assert(stats.bytes == 9 * sizeof(GLfloat));
+    assert(stats.uploads == 1);
+    assert(stats.wraps == 0);
+
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+
+    // the ring is allocated up front. the mock names every buffer 0, so
+    // binding them is skipped as redundant
+    GLuint buffers[2] = {0};
+    test_glGenBuffers(2, buffers);
+    for (int i = 0; i < 2; i++) {
+        test_glBufferData(GL_ARRAY_BUFFER, 64 * 1024, NULL, GL_DYNAMIC_DRAW);
+    }
+
+    // the drawn range is uploaded and drawn from offset 0
+    test_glBufferSubData(GL_ARRAY_BUFFER, 0, 9 * sizeof(GLfloat), vert + 3);
+    test_glVertexPointer(3, GL_FLOAT, 3 * sizeof(GLfloat), NULL);
+    test_glDrawArrays(GL_TRIANGLES, 0, 3);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+
+    // a draw whose arrays don't all fit wraps before its first array,
+    // not between two of them
+    for (int i = 0; i < BIG * 4; i++) {
+        big_color[i] = i;
+    }
+    glDrawArrays(GL_TRIANGLES, 1, 3);
+    test_glBufferSubData(GL_ARRAY_BUFFER, 0, 9 * sizeof(GLfloat), vert + 3);
+    test_glVertexPointer(3, GL_FLOAT, 3 * sizeof(GLfloat), NULL);
+    test_glDrawArrays(GL_TRIANGLES, 0, 3);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+
+    glVertexPointer(3, GL_FLOAT, 0, big_vert);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_FLOAT, 0, big_color);
+    glDrawArrays(GL_TRIANGLES, 0, BIG);
+    stream_frame();
+    stream_stats(&stats);
+    assert(stats.uploads == 3);
+    assert(stats.wraps == 1);
+
+    test_glVertexPointer(3, GL_FLOAT, 0, big_vert);
+    test_glEnableClientState(GL_COLOR_ARRAY);
+    test_glColorPointer(4, GL_FLOAT, 0, big_color);
+    test_glBufferData(GL_ARRAY_BUFFER, 64 * 1024, NULL, GL_DYNAMIC_DRAW);
+    test_glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(big_vert), big_vert);
+    test_glVertexPointer(3, GL_FLOAT, 3 * sizeof(GLfloat), NULL);
+    test_glBufferSubData(GL_ARRAY_BUFFER, sizeof(big_vert), sizeof(big_color), big_color);
+    // the mock can only compare pointers it can read, not buffer offsets
+    glColorPointer_INDEXED *color = mock_cur();
+    assert(color && color->func == glColorPointer_INDEX);
+    assert(color->args.a4 == (GLvoid *)sizeof(big_vert));
+    mock_shift();
+    test_glDrawArrays(GL_TRIANGLES, 0, BIG);
+    test_glVertexPointer(3, GL_FLOAT, 0, big_vert);
+    test_glColorPointer(4, GL_FLOAT, 0, big_color);
+    mock_return;
+}
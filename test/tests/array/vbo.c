@@ -0,0 +1,64 @@
+#include "buffer.h"
+
+int main() {
+    // every buffer is shadowed from its first upload by default
+    GLdouble vert[] = {
+        0, 0, 0,
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    glBindBuffer(GL_ARRAY_BUFFER, 1);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_STREAM_DRAW);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_DOUBLE, 0, NULL);
+    // GL_DOUBLE is converted from the buffer's shadow copy
+    glDrawArrays(GL_QUADS, 2, 4);
+
+    // writes through a mapping are uploaded on unmap
+    GLdouble *map = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+    map[6] = 9;
+    assert(glUnmapBuffer(GL_ARRAY_BUFFER));
+    glDrawArrays(GL_QUADS, 2, 4);
+
+    GLint size;
+    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+    assert(size == sizeof(vert));
+
+    GLfloat before[] = {
+        2, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    GLfloat after[] = {
+        9, 2, 2,
+        3, 3, 3,
+        4, 4, 4,
+        5, 5, 5,
+    };
+    GLdouble mapped[18];
+    memcpy(mapped, vert, sizeof(vert));
+    mapped[6] = 9;
+    GLushort indices[] = {0, 1, 3, 1, 2, 3};
+    test_glBindBuffer(GL_ARRAY_BUFFER, 1);
+    test_glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_DYNAMIC_DRAW);
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_DOUBLE, 0, NULL);
+
+    // blocks draw from our memory with the buffer unbound
+    test_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    test_glVertexPointer(3, GL_FLOAT, 0, before);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    test_glBindBuffer(GL_ARRAY_BUFFER, 1);
+
+    test_glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vert), mapped);
+
+    test_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    test_glVertexPointer(3, GL_FLOAT, 0, after);
+    test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    test_glBindBuffer(GL_ARRAY_BUFFER, 1);
+    mock_return;
+}
@@ -0,0 +1,72 @@
+#include "pixel.h"
+
+// enough pixels for the vector loops plus a scalar tail
+#define N 37
+
+int main() {
+    GLubyte bgra[N * 4], bgr[N * 3];
+    GLfloat rgbaf[N * 4];
+    GLushort argb1555[N];
+    for (int i = 0; i < N * 4; i++) {
+        bgra[i] = i * 7;
+        rgbaf[i] = (i % 11) / 8.0f - 0.25f;
+    }
+    for (int i = 0; i < N * 3; i++) {
+        bgr[i] = i * 5;
+    }
+    for (int i = 0; i < N; i++) {
+        argb1555[i] = i * 1777;
+    }
+
+    GLubyte *out;
+    assert(pixel_convert(bgra, (GLvoid **)&out, N, 1, GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N; i++) {
+        GLubyte *s = &bgra[i * 4], *d = &out[i * 4];
+        assert(d[0] == s[2] && d[1] == s[1] && d[2] == s[0] && d[3] == s[3]);
+    }
+    assert(pixel_convert(bgra, (GLvoid **)&out, N, 1, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8, GL_RGBA, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N; i++) {
+        GLubyte *s = &bgra[i * 4], *d = &out[i * 4];
+        assert(d[0] == s[1] && d[1] == s[2] && d[2] == s[3] && d[3] == s[0]);
+    }
+    assert(pixel_convert(bgra, (GLvoid **)&out, N, 1, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, GL_RGBA, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N; i++) {
+        GLubyte *s = &bgra[i * 4], *d = &out[i * 4];
+        assert(d[0] == s[3] && d[1] == s[2] && d[2] == s[1] && d[3] == s[0]);
+    }
+
+    assert(pixel_convert(bgr, (GLvoid **)&out, N, 1, GL_BGR, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N; i++) {
+        GLubyte *s = &bgr[i * 3], *d = &out[i * 3];
+        assert(d[0] == s[2] && d[1] == s[1] && d[2] == s[0]);
+    }
+    assert(pixel_convert(bgr, (GLvoid **)&out, N, 1, GL_BGR, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N; i++) {
+        GLubyte *s = &bgr[i * 3], *d = &out[i * 4];
+        assert(d[0] == s[2] && d[1] == s[1] && d[2] == s[0] && d[3] == 255);
+    }
+    assert(pixel_convert(bgr, (GLvoid **)&out, N, 1, GL_RGB, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N; i++) {
+        GLubyte *s = &bgr[i * 3], *d = &out[i * 4];
+        assert(d[0] == s[0] && d[1] == s[1] && d[2] == s[2] && d[3] == 255);
+    }
+
+    assert(pixel_convert(rgbaf, (GLvoid **)&out, N, 1, GL_RGBA, GL_FLOAT, GL_RGBA, GL_UNSIGNED_BYTE));
+    for (int i = 0; i < N * 4; i++) {
+        GLfloat f = rgbaf[i] < 0 ? 0 : (rgbaf[i] > 1 ? 1 : rgbaf[i]);
+        assert(out[i] == (GLubyte)(f * 255.0f + 0.5f));
+    }
+
+    GLushort *out16;
+    assert(pixel_convert(argb1555, (GLvoid **)&out16, N, 1, GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV,
+                         GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1));
+    for (int i = 0; i < N; i++) {
+        GLushort s = argb1555[i], d = out16[i];
+        // red, green, blue, alpha
+        assert((d >> 11) == ((s >> 10) & 31));
+        assert(((d >> 6) & 31) == ((s >> 5) & 31));
+        assert(((d >> 1) & 31) == (s & 31));
+        assert((d & 1) == (s >> 15));
+    }
+    mock_return;
+}
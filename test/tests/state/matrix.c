@@ -0,0 +1,24 @@
+int main() {
+    GLfloat vert[] = {0, 0, 0, 1, 1, 1, 2, 2, 2};
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glMatrixMode(GL_MODELVIEW);
+    glTranslatef(1, 2, 3);
+    glScalef(2, 2, 2);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    // nothing changed, so nothing is uploaded
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    GLfloat m[] = {
+        2, 0, 0, 0,
+        0, 2, 0, 0,
+        0, 0, 2, 0,
+        1, 2, 3, 1,
+    };
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    test_glLoadMatrixf(m);
+    test_glDrawArrays(GL_TRIANGLES, 0, 3);
+    test_glDrawArrays(GL_TRIANGLES, 0, 3);
+    mock_return;
+}
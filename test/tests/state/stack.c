@@ -0,0 +1,33 @@
+int main() {
+    GLint depth;
+    glMatrixMode(GL_MODELVIEW);
+    glGetIntegerv(GL_MODELVIEW_STACK_DEPTH, &depth);
+    assert(depth == 1);
+
+    // deeper than the preallocated stack
+    for (int i = 0; i < 40; i++) {
+        glPushMatrix();
+        glTranslatef(1, 0, 0);
+    }
+    glGetIntegerv(GL_MODELVIEW_STACK_DEPTH, &depth);
+    assert(depth == 41);
+    assert(simd4f_get_x(state.matrix.model.matrix.w) == 40);
+    for (int i = 0; i < 40; i++) {
+        glPopMatrix();
+    }
+    assert(glGetError() == GL_NO_ERROR);
+    assert(simd4f_get_x(state.matrix.model.matrix.w) == 0);
+    glPopMatrix();
+    assert(glGetError() == GL_STACK_UNDERFLOW);
+
+    glMatrixMode(GL_PROJECTION);
+    for (int i = 1; i < MAX_MATRIX_STACK_DEPTH; i++) {
+        glPushMatrix();
+    }
+    assert(glGetError() == GL_NO_ERROR);
+    glPushMatrix();
+    assert(glGetError() == GL_STACK_OVERFLOW);
+    glGetIntegerv(GL_PROJECTION_STACK_DEPTH, &depth);
+    assert(depth == MAX_MATRIX_STACK_DEPTH);
+    mock_return;
+}
@@ -0,0 +1,24 @@
+#include "matrix.h"
+
+int main() {
+    // not a multiple of four, to cover the tail
+    GLfloat in[] = {
+        0, 0, 0,
+        1, 2, 3,
+        -1, -2, -3,
+        4, 5, 6,
+        0.5, 0.25, 0.125,
+        -8, 8, -8,
+    };
+    GLfloat out[18];
+    glMatrixMode(GL_MODELVIEW);
+    glTranslatef(1, 2, 3);
+    glScalef(2, 4, 0.5);
+    gl_transform_vertices(out, in, 6);
+    for (int i = 0; i < 6; i++) {
+        assert(out[i * 3 + 0] == in[i * 3 + 0] * 2 + 1);
+        assert(out[i * 3 + 1] == in[i * 3 + 1] * 4 + 2);
+        assert(out[i * 3 + 2] == in[i * 3 + 2] * 0.5f + 3);
+    }
+    mock_return;
+}
@@ -0,0 +1,42 @@
+#include "texgen.h"
+
+int main() {
+    GLfloat vert[] = {
+        1, 2, 3,
+        4, 5, 6,
+    };
+    block_t block = {0};
+    block.vert = vert;
+    block.vert_len = 2;
+
+    GLfloat plane[] = {1, 0, 0, 0};
+    glEnable(GL_TEXTURE_GEN_S);
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGenfv(GL_S, GL_OBJECT_PLANE, plane);
+    GLfloat *out = texgen_coords(&block, 0);
+    assert(out[0] == 1 && out[2] == 4);
+
+    // the block's vertices are assumed static, so a changed vertex shows
+    // whether the coords were regenerated
+    vert[0] = 7;
+    glTranslatef(1, 0, 0);
+    texgen_coords(&block, 0);
+    assert(out[0] == 1);
+
+    // eye linear depends on the modelview
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+    texgen_coords(&block, 0);
+    assert(out[0] == 8);
+
+    // reloading the same matrix keeps the cache
+    vert[0] = 9;
+    glLoadIdentity();
+    glTranslatef(1, 0, 0);
+    texgen_coords(&block, 0);
+    assert(out[0] == 8);
+
+    glTranslatef(1, 0, 0);
+    texgen_coords(&block, 0);
+    assert(out[0] == 11);
+    mock_return;
+}
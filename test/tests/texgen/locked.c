@@ -0,0 +1,47 @@
+int main() {
+    GLfloat vert[] = {
+        3, 0, 0,
+        3, 3, 0,
+        0, 3, 0,
+        0, 0, 0,
+    };
+    GLfloat s_plane[] = {1, 0, 0, 0};
+    GLfloat t_plane[] = {0, 1, 0, 0};
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 3, 3, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGenfv(GL_S, GL_OBJECT_PLANE, s_plane);
+    glTexGenfv(GL_T, GL_OBJECT_PLANE, t_plane);
+    glEnable(GL_TEXTURE_GEN_S);
+    glEnable(GL_TEXTURE_GEN_T);
+
+    // generated coords aren't scaled for the npot texture, locked or not
+    glLockArraysEXT(0, 4);
+    glDrawArrays(GL_QUADS, 0, 4);
+    glUnlockArraysEXT();
+    glDrawArrays(GL_QUADS, 0, 4);
+
+    GLfloat tex[] = {
+        3, 0,
+        3, 3,
+        0, 3,
+        0, 0,
+    };
+    GLushort indices[] = {0, 1, 3, 1, 2, 3};
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 3, 3, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    for (int i = 0; i < 2; i++) {
+        test_glVertexPointer(3, GL_FLOAT, 0, vert);
+        test_glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        test_glTexCoordPointer(2, GL_FLOAT, 0, tex);
+        test_glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+        test_glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    }
+    mock_return;
+}
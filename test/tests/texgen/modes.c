@@ -0,0 +1,52 @@
+#include "texgen.h"
+
+int main() {
+    GLfloat vert[] = {
+        0, 0, -1,
+        1, 2, -1,
+        2, 4, -1,
+        3, 6, -1,
+        4, 8, -1,
+    };
+    GLfloat normal[] = {
+        0, 0, 1,
+        0, 1, 0,
+        1, 0, 0,
+        0, 0, 1,
+        0, -1, 0,
+    };
+    block_t block = {0};
+    block.vert = vert;
+    block.normal = normal;
+    block.vert_len = 5;
+
+    GLfloat plane[] = {1, 0, 0, 0.5};
+    glEnable(GL_TEXTURE_GEN_S);
+    glEnable(GL_TEXTURE_GEN_T);
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGenfv(GL_S, GL_OBJECT_PLANE, plane);
+    glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_NORMAL_MAP);
+    GLfloat *out = gen_tex_coords(&block, 0);
+    for (int i = 0; i < 5; i++) {
+        assert(out[i * 2 + 0] == vert[i * 3] + 0.5f);
+        assert(out[i * 2 + 1] == normal[i * 3 + 1]);
+    }
+
+    // eye linear folds the modelview into the plane
+    glTranslatef(1, 0, 0);
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+    // and the storage is reused
+    assert(gen_tex_coords(&block, 0) == out);
+    for (int i = 0; i < 5; i++) {
+        assert(out[i * 2 + 0] == vert[i * 3] + 1.5f);
+    }
+
+    // straight on at the origin the sphere map hits the middle
+    glLoadIdentity();
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP);
+    glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP);
+    block.vert_len = 1;
+    gen_tex_coords(&block, 0);
+    assert(out[0] == 0.5f && out[1] == 0.5f);
+    mock_return;
+}
@@ -0,0 +1,44 @@
+#include "texture.h"
+
+int main() {
+    setenv("LIBGL_ASYNC_TEXTURES", "1", 1);
+    GLubyte bgra[] = {
+        1, 2, 3, 4,   5, 6, 7, 8,
+        9, 10, 11, 12,   13, 14, 15, 16,
+    };
+    GLubyte rgba[] = {
+        3, 2, 1, 4,   7, 6, 5, 8,
+        11, 10, 9, 12,   15, 14, 13, 16,
+    };
+    GLfloat vert[] = {0, 0, 0, 1, 0, 0, 1, 1, 0};
+    GLubyte read[4];
+
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_BGRA, GL_UNSIGNED_BYTE, bgra);
+    // the app's memory is copied, it can change straight away
+    memset(bgra, 0, sizeof(bgra));
+    glBindTexture(GL_TEXTURE_2D, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glEnable(GL_TEXTURE_2D);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vert);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, read);
+
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glEnable(GL_TEXTURE_2D);
+    test_glEnableClientState(GL_VERTEX_ARRAY);
+    test_glVertexPointer(3, GL_FLOAT, 0, vert);
+    // only the texture being drawn with is uploaded at the draw
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    test_glDrawArrays(GL_TRIANGLES, 0, 3);
+    // the rest waits for a sync point, bound just long enough to upload
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, read);
+    mock_return;
+}
@@ -0,0 +1,55 @@
+#include "texture.h"
+
+int main() {
+    // room for two of the three 1 KB textures
+    setenv("LIBGL_TEXTURE_BUDGET", "2", 1);
+    GLubyte rgba[16 * 16 * 4];
+    for (int i = 0; i < sizeof(rgba); i++) {
+        // transparent rows, then a gradient
+        rgba[i] = i < 300 ? 0 : (i / 64) * 3 + (i % 7);
+    }
+    GLuint textures[] = {1, 2, 3};
+    GLclampf priorities[] = {1, 0.5, 0.25};
+    GLboolean residences[3];
+
+    for (int i = 0; i < 3; i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        test_glBindTexture(GL_TEXTURE_2D, textures[i]);
+        test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+    assert(glAreTexturesResident(3, textures, residences));
+    glPrioritizeTextures(3, textures, priorities);
+
+    // binding 1 leaves 3 over budget, the lowest priority goes
+    glBindTexture(GL_TEXTURE_2D, 1);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glBindTexture(GL_TEXTURE_2D, 3);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+
+    // and comes back from our copy when it's bound again, evicting 2
+    glBindTexture(GL_TEXTURE_2D, 3);
+    test_glBindTexture(GL_TEXTURE_2D, 3);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glBindTexture(GL_TEXTURE_2D, 3);
+
+    assert(! glAreTexturesResident(3, textures, residences));
+    assert(residences[0] && ! residences[1] && residences[2]);
+
+    // the copy also brings back the alpha an opaque texture was stored without
+    GLubyte opaque[] = {1, 2, 3, 255,   4, 5, 6, 255};
+    GLubyte rgb[] = {1, 2, 3,   4, 5, 6};
+    GLubyte translucent[] = {7, 8, 9, 10};
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, opaque);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    test_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    test_glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 1, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, translucent);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, opaque);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 1, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, translucent);
+    mock_return;
+}
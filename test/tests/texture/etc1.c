@@ -0,0 +1,81 @@
+#include <dirent.h>
+#include <unistd.h>
+#include "etc1.h"
+#include "texture.h"
+
+int main() {
+    // the cache makes its own directories
+    char cache[64], dir[64], path[128] = {0};
+    snprintf(cache, sizeof(cache), "/tmp/etc1.%d", (int)getpid());
+    snprintf(dir, sizeof(dir), "%s/etc1", cache);
+    setenv("LIBGL_ETC1", "1", 1);
+    setenv("LIBGL_ETC1_CACHE", dir, 1);
+    GLubyte grey[4 * 4 * 3];
+    memset(grey, 132, sizeof(grey));
+    // both halves on the 5 bit base color 132, +2 from the first table
+    GLubyte block[] = {0x80, 0x80, 0x80, 0x02, 0, 0, 0, 0};
+    GLubyte cached[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    GLubyte decoded[4 * 4 * 3];
+    memset(decoded, 134, sizeof(decoded));
+    GLubyte sub[] = {9, 9, 9, 0};
+
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_ETC1_RGB8_OES, 4, 4, 0, 8, block);
+
+    // the encoding went to the cache, and is read back from it next time
+    DIR *d = opendir(dir);
+    assert(d);
+    struct dirent *entry;
+    while ((entry = readdir(d))) {
+        if (strstr(entry->d_name, ".etc1")) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        }
+    }
+    closedir(d);
+    assert(*path);
+    FILE *fd = fopen(path, "r+b");
+    fseek(fd, -8, SEEK_END);
+    fwrite(cached, 1, sizeof(cached), fd);
+    fclose(fd);
+    glBindTexture(GL_TEXTURE_2D, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_ETC1_RGB8_OES, 4, 4, 0, 8, cached);
+
+    // a file with a header that doesn't match is encoded again
+    fd = fopen(path, "r+b");
+    fputc('X', fd);
+    fclose(fd);
+    glBindTexture(GL_TEXTURE_2D, 3);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, grey);
+    test_glBindTexture(GL_TEXTURE_2D, 3);
+    test_glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_ETC1_RGB8_OES, 4, 4, 0, 8, block);
+    unlink(path);
+    rmdir(dir);
+    rmdir(cache);
+
+    // a sub image needs the texture back as RGB
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, sub);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, decoded);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, sub);
+
+    // so does a copy from the framebuffer
+    glBindTexture(GL_TEXTURE_2D, 3);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, 1, 1);
+    test_glBindTexture(GL_TEXTURE_2D, 3);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, decoded);
+    test_glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, 1, 1);
+
+    // while a copied base level replaces the encoding
+    glBindTexture(GL_TEXTURE_2D, 2);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 0, 0, 4, 4, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, sub);
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 0, 0, 4, 4, 0);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, sub);
+    mock_return;
+}
@@ -0,0 +1,42 @@
+#include "texture.h"
+
+int main() {
+    setenv("LIBGL_16BIT", "1", 1);
+    setenv("LIBGL_16BIT_MIN", "0", 1);
+    setenv("LIBGL_16BIT_DENY", "2", 1);
+    GLubyte rgb[] = {255, 0, 0,   16, 16, 16};
+    GLubyte graded[] = {255, 255, 255, 128,   0, 0, 0, 128};
+    GLubyte binary[] = {255, 0, 0, 255,   0, 0, 255, 0};
+    // the second pixel is dithered up by half a step
+    GLushort rgb565[] = {0xf800, 0x1082};
+    GLushort rgba4444[] = {0xfff8, 0x0008};
+    GLushort rgba5551[] = {0xf801, 0x003e};
+
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, rgb565);
+
+    // alpha that isn't just on or off gets 4 bits
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, graded);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, rgba4444);
+
+    // cutout alpha fits in one bit
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, binary);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, rgba5551);
+
+    // until graded alpha replaces it, then it needs the 4 bits after all
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGBA, GL_UNSIGNED_BYTE, graded);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, rgba4444);
+
+    // denied textures keep full precision
+    glBindTexture(GL_TEXTURE_2D, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    mock_return;
+}
@@ -0,0 +1,40 @@
+#include "texture.h"
+
+int main() {
+    setenv("LIBGL_MAX_TEXTURE", "5", 1);
+    // 10x2 RGBA, halved to fit in 5 pixels
+    GLubyte rgba[10 * 2 * 4];
+    GLubyte box[5 * 4];
+    for (int i = 0; i < sizeof(rgba); i++) {
+        rgba[i] = i * 7 + i / 40;
+    }
+    for (int x = 0; x < 5; x++) {
+        for (int c = 0; c < 4; c++) {
+            GLubyte *p = rgba + x * 8 + c;
+            box[x * 4 + c] = (p[0] + p[4] + p[40] + p[44] + 2) / 4;
+        }
+    }
+    // a sub image lands at half the offset
+    GLubyte sub[2 * 2 * 4];
+    GLubyte sub_box[4];
+    for (int i = 0; i < sizeof(sub); i++) {
+        sub[i] = 255 - i * 3;
+    }
+    for (int c = 0; c < 4; c++) {
+        sub_box[c] = (sub[c] + sub[c + 4] + sub[c + 8] + sub[c + 12] + 2) / 4;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 10, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 5, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 5, 1, GL_RGBA, GL_UNSIGNED_BYTE, box);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 4, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, sub);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 2, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, sub_box);
+
+    // textures that fit are left alone
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, sub);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, sub);
+    mock_return;
+}
@@ -0,0 +1,51 @@
+#include "texture.h"
+
+int main() {
+    GLubyte opaque[] = {1, 2, 3, 255,   4, 5, 6, 255};
+    GLubyte swizzled[] = {3, 2, 1, 255,   6, 5, 4, 255};
+    GLubyte red[] = {7, 8};
+    GLubyte lum_alpha[] = {7, 7,   8, 8};
+    GLubyte rgba[] = {9, 10, 11, 0,   12, 13, 14, 15};
+    GLubyte rgb[] = {1, 2, 3,   4, 5, 6};
+
+    glBindTexture(GL_TEXTURE_2D, 1);
+    // opaque data keeps its alpha channel, as there's no copy of the texture
+    // to bring it back from if a sub image needs it
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_BGRA, GL_UNSIGNED_BYTE, opaque);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_RGBA, GL_UNSIGNED_BYTE, swizzled);
+
+    // so a sub image with alpha goes straight in
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+    // a base level copied from the framebuffer takes the copy's format
+    glBindTexture(GL_TEXTURE_2D, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, 2, 1, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    test_glBindTexture(GL_TEXTURE_2D, 2);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    test_glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, 2, 1, 0);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glBindTexture(GL_TEXTURE_2D, 1);
+    test_glBindTexture(GL_TEXTURE_2D, 1);
+
+    // one channel is enough for luminance
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, 2, 1, 0, GL_RED, GL_UNSIGNED_BYTE, red);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, 2, 1, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+    test_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_LUMINANCE, GL_UNSIGNED_BYTE, red);
+    test_glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // intensity keeps its value in both channels
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_INTENSITY, 2, 1, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, red);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, 2, 1, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 1, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, lum_alpha);
+
+    // data that's already as small as it gets goes straight through
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, red);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, 2, 1, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, red);
+    mock_return;
+}
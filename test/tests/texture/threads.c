@@ -0,0 +1,21 @@
+#include "pool.h"
+#include "texture.h"
+
+#define SIZE 256
+
+static GLubyte bgra[SIZE * SIZE * 4], rgba[SIZE * SIZE * 4];
+
+int main() {
+    setenv("LIBGL_THREADS", "4", 1);
+    assert(pool_threads() == 4);
+    for (int i = 0; i < SIZE * SIZE; i++) {
+        GLubyte *s = &bgra[i * 4], *d = &rgba[i * 4];
+        s[0] = i; s[1] = i >> 8; s[2] = i * 3; s[3] = i * 5;
+        d[0] = s[2]; d[1] = s[1]; d[2] = s[0]; d[3] = s[3];
+    }
+    // big enough to be converted in bands, all in one strip
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SIZE, SIZE, 0, GL_BGRA, GL_UNSIGNED_BYTE, bgra);
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SIZE, SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    mock_return;
+}
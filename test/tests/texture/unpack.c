@@ -0,0 +1,45 @@
+#include "texture.h"
+
+int main() {
+    // 2x2 BGRA out of a 3 pixel wide image, one pixel in
+    GLubyte bgra[] = {
+        0, 0, 0, 0,   1, 2, 3, 4,   5, 6, 7, 8,
+        0, 0, 0, 0,   9, 10, 11, 12,   13, 14, 15, 16,
+    };
+    GLubyte rgba[] = {
+        3, 2, 1, 4,   7, 6, 5, 8,
+        11, 10, 9, 12,   15, 14, 13, 16,
+    };
+    // 1 pixel RGB rows with the default alignment of 4
+    GLubyte rgb[] = {
+        1, 2, 3, 0,
+        4, 5, 6, 0,
+    };
+    GLubyte strip[] = {4, 5, 6};
+
+    // plain uploads go straight through
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 3);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_BGRA, GL_UNSIGNED_BYTE, bgra);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+    // converted into a strip and uploaded into the allocated level
+    test_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+    // the strip is reused, so check each upload before the next one
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+    // 3 byte strip rows need a packed alignment
+    test_glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    test_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, strip);
+    test_glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    mock_return;
+}